@@ -0,0 +1,207 @@
+#include "multikey_FHE.h"
+#include "multikey_FHE_sampler.h"
+#include "multikey_FHE_pool.h"
+#include "multikey_FHE_simd.h"
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// 「小さい」係数の多項式を生成 (分布は SetSmallPolyDistribution で選ぶ。既定はガウス分布)
+Poly GenerateSmallPoly(unsigned int degree, std::shared_ptr<ILNativeParams> params) {
+    return GenerateSmallPoly(GetSmallPolyDistribution(), GetSmallPolySigma(), params);
+}
+
+// 鍵生成
+bool KeyGen(unsigned int degree, std::shared_ptr<ILNativeParams> params, Poly& sk, Poly& pk) {
+    Poly f_prime = GenerateSmallPoly(degree, params);
+    Poly g = GenerateSmallPoly(degree, params);
+    Poly f = f_prime * 2 + 1;
+
+
+    try {
+        f.SwitchFormat();
+        g.SwitchFormat();
+
+        // ★ 修正点: 逆元を計算する前に、まず存在するかどうかをチェックする ★
+        // このチェックにより、ゼロ除算が原因のクラッシュを未然に防ぎます。
+        // InverseExists は今の形式の値が 0 でないかを見るだけなので、評価形式 (スロットごとの逆数が
+        // 逆元になる形式) に変えてから調べる。係数形式で調べると f の係数に 0 が1つでもあれば失敗し、
+        // N が大きい (N = 1024 なら 0.875^1023 程度しか通らない) か sigma が小さいと再試行が終わらない。
+        if (!f.InverseExists()) {
+            return false; // 逆元が存在しない場合は、失敗としてmain関数に通知し、再試行を促す
+        }
+
+        Poly f_inv = f.MultiplicativeInverse();
+
+        sk = f;
+        // pk = 2g * f^{-1} を g の上で計算する
+        MultInPlace(g, f_inv);
+        AddInPlace(g, g);
+        pk = std::move(g);
+        return true; // 成功
+    } catch (const std::exception& e) {
+        // InverseExists()でチェック済みですが、念のためtry-catchも残します
+        return false; // 予期せぬエラーで失敗
+    }
+}
+
+// 暗号化
+Poly Encrypt(const Poly& pk, int message, unsigned int degree, std::shared_ptr<ILNativeParams> params) {
+    Poly c(params, EVALUATION, true);
+    EncryptInto(c, pk, message, params);
+    return c;
+}
+
+// c[i] = pk[i]*s[i] + 2e[i] + m (評価形式。c は s, e と同じでもよい)
+// 定数 m の NTT は全スロットが m なので、m は評価形式のまま全スロットに足す (NTT は s と e の2回だけ)
+static void FusedEncrypt(Poly& c, const Poly& pk, const Poly& s, const Poly& e, int message) {
+    const NativeInteger& modulus = pk.GetModulus();
+    const NativeInteger mu = modulus.ComputeMu();
+    const NativeInteger m(static_cast<uint64_t>(message & 1)); // 平文は mod 2 (DCRT 版・パック暗号化と同じく下位ビットだけを使う)
+    const usint n = pk.GetLength();
+    for (usint i = 0; i < n; ++i) {
+        NativeInteger x = pk[i].ModMulFast(s[i], modulus, mu);
+        x.ModAddFastEq(e[i], modulus);
+        x.ModAddFastEq(e[i], modulus);
+        x.ModAddFastEq(m, modulus);
+        c[i] = x;
+    }
+}
+
+void EncryptInto(Poly& c, const Poly& pk, int message, std::shared_ptr<ILNativeParams> params) {
+    if (c.IsEmpty() || c.GetModulus() != params->GetModulus() || c.GetLength() != params->GetRingDimension()) {
+        c = Poly(params, EVALUATION, true);
+    }
+    c.OverrideFormat(EVALUATION);
+    PooledPoly s(params, COEFFICIENT);
+    PooledPoly e(params, COEFFICIENT);
+    SampleSmallPoly(s.poly);
+    SampleSmallPoly(e.poly);
+    s.poly.SwitchFormat();
+    e.poly.SwitchFormat();
+    FusedEncrypt(c, pk, s.poly, e.poly, message);
+}
+
+Poly EncryptWithNoise(const Poly& pk, Poly s, Poly e, int message) {
+    s.SwitchFormat();
+    e.SwitchFormat();
+    FusedEncrypt(s, pk, s, e, message);
+    return s;
+}
+
+// 復号 (定数項だけが必要なので c * sk_combined の積も逆 NTT も作らない)
+int Decrypt(const Poly& sk_combined, const Poly& c) {
+    int64_t modulus_int = c.GetModulus().ConvertToInt();
+    return CenteredParity(ConstantTerm(c, sk_combined), modulus_int);
+}
+
+// 同型加算
+Poly EvaluateAdd(const Poly& c1, const Poly& c2) {
+    Poly result = c1;
+    AddInPlace(result, c2);
+    return result;
+}
+
+// 同型乗算 (評価形式のスロットごとの積)
+Poly EvaluateMult(const Poly& c1, const Poly& c2) {
+    Poly result = c1;
+    MultInPlace(result, c2);
+    return result;
+}
+
+// スロットごとの演算の前提 (OpenFHE の operator+ / operator* と同じく、合わなければ例外)
+// 次数が違うとバッファの外を読み、係数形式だとスロットごとの積は多項式の積にならない
+static void CheckSlotwise(const char* op, const Poly& a, const Poly& b) {
+    if (a.GetLength() != b.GetLength() || a.GetModulus() != b.GetModulus()) {
+        throw std::invalid_argument(std::string(op) + ": polynomials do not share ring dimension and modulus");
+    }
+    if (a.GetFormat() != EVALUATION || b.GetFormat() != EVALUATION) {
+        throw std::invalid_argument(std::string(op) + ": both polynomials must be in EVALUATION format");
+    }
+}
+
+// スロットごとの演算は multikey_FHE_simd.h のカーネル (実行時に AVX-512 / AVX2 / スカラーを選ぶ) で行う
+void AddInPlace(Poly& c, const Poly& other) {
+    CheckSlotwise("AddInPlace", c, other);
+    VecAddMod(SlotData(c), SlotData(c), SlotData(other), c.GetLength(), c.GetModulus().ConvertToInt());
+}
+
+void MultInPlace(Poly& c, const Poly& other) {
+    CheckSlotwise("MultInPlace", c, other);
+    VecMulMod(SlotData(c), SlotData(c), SlotData(other), c.GetLength(), c.GetModulus().ConvertToInt());
+}
+
+void MulAdd(Poly& c, const Poly& a, const Poly& b, const Poly& d) {
+    CheckSlotwise("MulAdd", a, b);
+    CheckSlotwise("MulAdd", a, d);
+    if (c.IsEmpty() || c.GetModulus() != a.GetModulus() || c.GetLength() != a.GetLength()) {
+        c = Poly(a.GetParams(), EVALUATION, true);
+    }
+    c.OverrideFormat(EVALUATION);
+    const NativeInteger& modulus = a.GetModulus();
+    const NativeInteger mu = modulus.ComputeMu();
+    const usint n = a.GetLength();
+    for (usint i = 0; i < n; ++i) {
+        NativeInteger x = a[i].ModMulFast(b[i], modulus, mu);
+        c[i] = x.ModAddFastEq(d[i], modulus);
+    }
+}
+
+void MulAddInPlace(Poly& acc, const Poly& a, const Poly& b) {
+    MulAdd(acc, a, b, acc);
+}
+
+// パック暗号化
+// f = 2f'+1 ≡ 1 (mod 2) なので c*f = 2(gs + ef) + m*f ≡ m (mod 2) が全係数で成り立つ
+Poly EncryptPacked(const Poly& pk, const std::vector<int>& bits, unsigned int degree, std::shared_ptr<ILNativeParams> params) {
+    if (bits.size() > params->GetRingDimension()) {
+        throw std::invalid_argument("EncryptPacked: number of bits exceeds the ring dimension");
+    }
+    Poly s = GenerateSmallPoly(degree, params);
+    Poly e = GenerateSmallPoly(degree, params);
+    Poly m(params, COEFFICIENT, true);
+    for (size_t i = 0; i < bits.size(); ++i) {
+        m[i] = bits[i] & 1;
+    }
+    s.SwitchFormat();
+    e.SwitchFormat();
+    m.SwitchFormat();
+    Poly c = pk * s + e * 2 + m;
+    return c;
+}
+
+// パック復号 (先頭 count 個の係数を取り出す)
+std::vector<int> DecryptPacked(const Poly& sk_combined, const Poly& c, size_t count) {
+    Poly mu = c * sk_combined;
+    mu.SwitchFormat();
+    auto params = mu.GetParams();
+    int64_t modulus_int = params->GetModulus().ConvertToInt();
+    if (count > mu.GetLength()) {
+        count = mu.GetLength();
+    }
+    std::vector<int> bits(count);
+    for (size_t i = 0; i < count; ++i) {
+        bits[i] = CenteredParity(mu[i], modulus_int);
+    }
+    return bits;
+}
+
+int CenteredParity(const NativeInteger& value, int64_t modulus) {
+    int64_t result = value.ConvertToInt();
+    if (result > modulus / 2) {
+        result -= modulus;
+    }
+    return (result % 2 + 2) % 2;
+}
+
+NativeInteger ConstantTerm(const Poly& a, const Poly& b) {
+    CheckSlotwise("ConstantTerm", a, b);
+    const NativeInteger& modulus = a.GetModulus();
+    const usint n = a.GetLength();
+    NativeInteger sum(0);
+    for (usint i = 0; i < n; ++i) {
+        sum.ModAddFastEq(a[i].ModMul(b[i], modulus), modulus);
+    }
+    return sum.ModMul(NativeInteger(n).ModInverse(modulus), modulus);
+}
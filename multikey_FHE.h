@@ -0,0 +1,60 @@
+#ifndef MULTIKEY_FHE_H
+#define MULTIKEY_FHE_H
+
+#include "openfhe.h"
+#include <vector>
+#include <memory>
+#include "math/discretegaussiangenerator.h"
+
+// using宣言
+using lbcrypto::NativeInteger;
+using lbcrypto::ILNativeParams;
+using lbcrypto::NativePoly;
+
+using lbcrypto::DiscreteGaussianGeneratorImpl;
+using lbcrypto::NativeVector;
+using lbcrypto::RootOfUnity;
+
+// このコードでは低レベルな多項式を直接扱うため、NativePolyをPolyとして定義
+using Poly = NativePoly;
+
+// 小さい多項式 (鍵・雑音) のガウス分布の標準偏差
+const double SIGMA = 3.2;
+
+// 関数のプロトタイプ宣言
+Poly GenerateSmallPoly(unsigned int degree, std::shared_ptr<ILNativeParams> params);
+bool KeyGen(unsigned int degree, std::shared_ptr<ILNativeParams> params, Poly& sk, Poly& pk);
+Poly Encrypt(const Poly& pk, int message, unsigned int degree, std::shared_ptr<ILNativeParams> params);
+// 係数形式の s, e を受け取って pk*s + 2e + m を作る (Encrypt / EncryptBatch の共通部分)
+Poly EncryptWithNoise(const Poly& pk, Poly s, Poly e, int message);
+int Decrypt(const Poly& sk_combined, const Poly& c);
+Poly EvaluateAdd(const Poly& c1, const Poly& c2);
+Poly EvaluateMult(const Poly& c1, const Poly& c2);
+
+// 一時オブジェクトを作らない演算 (評価形式の要素ごとに計算する。出力は入力と同じでもよい)
+void AddInPlace(Poly& c, const Poly& other);
+void MultInPlace(Poly& c, const Poly& other);
+// c = a*b + d
+void MulAdd(Poly& c, const Poly& a, const Poly& b, const Poly& d);
+// acc += a*b
+void MulAddInPlace(Poly& acc, const Poly& a, const Poly& b);
+// 融合した暗号化: c に pk*s + 2e + m を1回の走査で書き込む
+// s, e はスレッドごとのプール (multikey_FHE_pool.h) から借りるので、c が確保済みならヒープ確保はない
+void EncryptInto(Poly& c, const Poly& pk, int message, std::shared_ptr<ILNativeParams> params);
+
+// パック暗号化 (1つの暗号文の各係数に1ビットずつ詰める)
+// 平文空間が mod 2 のため x^N+1 は (x+1)^N に分解され CRT スロットは作れない。
+// そこで係数パッキングを使う: m(x) = Σ bits[i] x^i
+//  - EvaluateAdd はスロット(係数)ごとの XOR になる
+//  - EvaluateMult はパック同士だと mod (2, x^N+1) の多項式積 (巡回畳み込み) になる。
+//    片方が Encrypt による単一ビット暗号文ならスロットごとの AND になる
+Poly EncryptPacked(const Poly& pk, const std::vector<int>& bits, unsigned int degree, std::shared_ptr<ILNativeParams> params);
+std::vector<int> DecryptPacked(const Poly& sk_combined, const Poly& c, size_t count);
+
+// 係数を (-q/2, q/2] に中心化してパリティを取り出す
+int CenteredParity(const NativeInteger& value, int64_t modulus);
+// 評価形式の a, b について、積 a*b の定数項を逆 NTT なしで求める
+// (負巡回 NTT では定数項 = N^{-1} Σ_j â_j b̂_j なので O(N) の内積で済む)
+NativeInteger ConstantTerm(const Poly& a, const Poly& b);
+
+#endif
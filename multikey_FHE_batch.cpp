@@ -0,0 +1,66 @@
+#include "multikey_FHE_batch.h"
+#include "multikey_FHE_sampler.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+std::vector<Poly> EncryptBatch(const Poly& pk, const std::vector<int>& messages, unsigned int degree, std::shared_ptr<ILNativeParams> params) {
+    const size_t count = messages.size();
+    const size_t blocks = (count + BATCH_BLOCK - 1) / BATCH_BLOCK;
+    std::vector<Poly> ciphertexts(count);
+
+#pragma omp parallel for schedule(dynamic)
+    for (size_t block = 0; block < blocks; ++block) {
+        const size_t begin = block * BATCH_BLOCK;
+        const size_t end = std::min(begin + BATCH_BLOCK, count);
+
+        // ブロック内の s, e をまとめて生成 (2個ずつ使う)
+        std::vector<Poly> noise = GenerateSmallPolys(2 * (end - begin), params);
+        for (size_t i = begin; i < end; ++i) {
+            const size_t k = 2 * (i - begin);
+            ciphertexts[i] = EncryptWithNoise(pk, std::move(noise[k]), std::move(noise[k + 1]), messages[i]);
+        }
+    }
+    return ciphertexts;
+}
+
+DecryptionKey PrecomputeDecryptionKey(const Poly& sk_combined) {
+    if (sk_combined.GetFormat() != EVALUATION) {
+        throw std::invalid_argument("PrecomputeDecryptionKey: key must be in EVALUATION format");
+    }
+    DecryptionKey result;
+    result.modulus = sk_combined.GetModulus();
+    const usint n = sk_combined.GetLength();
+    const NativeInteger n_inv = NativeInteger(n).ModInverse(result.modulus);
+    result.key.resize(n);
+    result.precon.resize(n);
+    for (usint i = 0; i < n; ++i) {
+        result.key[i] = sk_combined[i].ModMul(n_inv, result.modulus);
+        result.precon[i] = result.key[i].PrepModMulConst(result.modulus);
+    }
+    return result;
+}
+
+int Decrypt(const DecryptionKey& key, const Poly& c) {
+    if (c.GetFormat() != EVALUATION || c.GetModulus() != key.modulus || c.GetLength() != key.key.size()) {
+        throw std::invalid_argument("Decrypt: ciphertext does not match the decryption key");
+    }
+    const NativeInteger& modulus = key.modulus;
+    // 各項は q 未満なので 128 ビットに貯めて最後に1回だけ剰余を取る
+    unsigned __int128 sum = 0;
+    for (size_t i = 0; i < key.key.size(); ++i) {
+        sum += c[i].ModMulFastConst(key.key[i], modulus, key.precon[i]).ConvertToInt();
+    }
+    const uint64_t modulus_int = modulus.ConvertToInt();
+    return CenteredParity(NativeInteger(static_cast<uint64_t>(sum % modulus_int)), modulus_int);
+}
+
+std::vector<int> DecryptBatch(const DecryptionKey& key, const std::vector<Poly>& ciphertexts) {
+    std::vector<int> bits(ciphertexts.size());
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < ciphertexts.size(); ++i) {
+        bits[i] = Decrypt(key, ciphertexts[i]);
+    }
+    return bits;
+}
@@ -0,0 +1,30 @@
+#ifndef MULTIKEY_FHE_BATCH_H
+#define MULTIKEY_FHE_BATCH_H
+
+#include "multikey_FHE.h"
+
+// まとめて暗号化する
+// messages を BATCH_BLOCK 個ずつのブロックに分けて OpenMP のスレッドに配る。
+// 各ブロックは s, e を GenerateSmallPolys で一度に引き、EncryptWithNoise で暗号化する
+// (pk は評価形式のまま共有し、定数 m は NTT せずに評価形式で足す)。
+// まとめているのはサンプリングだけで、順方向 NTT はまとめていない: s, e の NTT は暗号文ごとに
+// 2回ずつ行う (m の NTT を省くので 3回から 2回に減る)。NativePoly の NTT は多項式1つ単位で、
+// 互いに独立な変換を束ねても演算量は減らないため、スループットはブロック単位の並列化で稼ぐ。
+const size_t BATCH_BLOCK = 256;
+
+std::vector<Poly> EncryptBatch(const Poly& pk, const std::vector<int>& messages, unsigned int degree, std::shared_ptr<ILNativeParams> params);
+
+// まとめて復号するための前計算済み合成鍵
+// key[i] = N^{-1} * F̂_i (評価形式) と、その Shoup 乗算用の前計算値を持つ。
+// 復号は Σ ĉ_i key[i] の内積1回 (O(N)) で、積の多項式も逆 NTT も作らない。
+struct DecryptionKey {
+    NativeInteger modulus;
+    std::vector<NativeInteger> key;
+    std::vector<NativeInteger> precon;
+};
+
+DecryptionKey PrecomputeDecryptionKey(const Poly& sk_combined);
+int Decrypt(const DecryptionKey& key, const Poly& c);
+std::vector<int> DecryptBatch(const DecryptionKey& key, const std::vector<Poly>& ciphertexts);
+
+#endif
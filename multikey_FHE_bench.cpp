@@ -0,0 +1,268 @@
+#include "multikey_FHE.h"
+#include "multikey_FHE_relin.h"
+#include "multikey_FHE_batch.h"
+#include "multikey_FHE_party.h"
+#include "multikey_FHE_circuit.h"
+#include "multikey_FHE_stream.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+// マイクロベンチマーク
+//   ./bench [--degree=8,1024,4096] [--bits=30,50] [--parties=2,4] [--threads=1,8]
+//           [--iterations=100] [--out=bench.json]
+// 各組み合わせで KeyGen / Encrypt / Decrypt / Evaluate* / 回路を測り、遅延の分位点・スループット・
+// 1回あたりのヒープ確保回数を JSON で出力する (--out がなければ標準出力)。
+
+using namespace std;
+
+// ---- ヒープ確保の計数 (このプログラム全体の operator new を置き換える) ----
+
+static std::atomic<uint64_t> allocation_count{0};
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// ---- 計測 ----
+
+struct BenchConfig {
+    unsigned int degree;
+    unsigned int bits;
+    unsigned int parties;
+    int threads;
+    size_t iterations;
+};
+
+struct BenchResult {
+    std::string name;
+    BenchConfig config;
+    size_t items_per_op = 1; // 1回の呼び出しで処理する暗号文の数 (スループットの単位)
+    std::vector<double> ns;
+    double allocations_per_op = 0;
+    std::vector<std::pair<std::string, double>> extra;
+};
+
+static double Percentile(std::vector<double> sorted, double p) {
+    std::sort(sorted.begin(), sorted.end());
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * (sorted.size() - 1) + 0.5));
+    return sorted[index];
+}
+
+// op を (ウォームアップ 1回のあと) iterations 回測る
+static BenchResult Measure(const std::string& name, const BenchConfig& config, size_t items_per_op,
+                           const std::function<void()>& op) {
+    BenchResult result;
+    result.name = name;
+    result.config = config;
+    result.items_per_op = items_per_op;
+    op();
+    const uint64_t allocations_before = allocation_count.load();
+    for (size_t i = 0; i < config.iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        op();
+        auto end = std::chrono::steady_clock::now();
+        result.ns.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    result.allocations_per_op = static_cast<double>(allocation_count.load() - allocations_before) / config.iterations;
+    return result;
+}
+
+static void WriteJson(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "{\n  \"benchmarks\": [";
+    for (size_t k = 0; k < results.size(); ++k) {
+        const BenchResult& r = results[k];
+        double mean = 0;
+        for (double ns : r.ns) {
+            mean += ns;
+        }
+        mean /= r.ns.size();
+        out << (k == 0 ? "\n" : ",\n") << "    {\"name\": \"" << r.name << "\", \"degree\": " << r.config.degree
+            << ", \"modulus_bits\": " << r.config.bits << ", \"parties\": " << r.config.parties
+            << ", \"threads\": " << r.config.threads << ", \"iterations\": " << r.ns.size()
+            << ", \"ns\": {\"min\": " << Percentile(r.ns, 0) << ", \"p50\": " << Percentile(r.ns, 0.5)
+            << ", \"p90\": " << Percentile(r.ns, 0.9) << ", \"p99\": " << Percentile(r.ns, 0.99)
+            << ", \"max\": " << Percentile(r.ns, 1) << ", \"mean\": " << mean << "}"
+            << ", \"items_per_sec\": " << r.items_per_op * 1e9 / mean
+            << ", \"allocations_per_op\": " << r.allocations_per_op;
+        for (const auto& extra : r.extra) {
+            out << ", \"" << extra.first << "\": " << extra.second;
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// ---- ベンチマーク本体 ----
+
+static void RunConfig(const BenchConfig& config, std::vector<BenchResult>& results) {
+    omp_set_num_threads(config.threads);
+    const unsigned int cyclotomic_order = 2 * config.degree;
+    NativeInteger modulus = lbcrypto::LastPrime<NativeInteger>(config.bits, cyclotomic_order);
+    auto params = std::make_shared<ILNativeParams>(cyclotomic_order, modulus,
+                                                   RootOfUnity<NativeInteger>(cyclotomic_order, modulus));
+
+    results.push_back(Measure("generate_small_poly", config, 1, [&] { GenerateSmallPoly(config.degree, params); }));
+
+    // 再試行の回数も数える
+    size_t attempts = 0;
+    BenchResult keygen = Measure("keygen", config, 1, [&] {
+        Poly sk, pk;
+        do {
+            ++attempts;
+        } while (!KeyGen(config.degree, params, sk, pk));
+    });
+    keygen.extra.emplace_back("attempts_per_key", static_cast<double>(attempts) / (config.iterations + 1));
+    results.push_back(keygen);
+
+    MultiKeyContext ctx = GenerateMultiKeyContext(config.parties, config.degree, params);
+    std::vector<unsigned int> all_parties;
+    for (unsigned int party = 0; party < config.parties; ++party) {
+        all_parties.push_back(party);
+    }
+    const Poly combined = CombinedKey(ctx, all_parties);
+    const Poly c0 = Encrypt(ctx.pk[0], 0, config.degree, params);
+    const Poly c1 = Encrypt(ctx.pk[1 % config.parties], 1, config.degree, params);
+
+    results.push_back(Measure("encrypt", config, 1, [&] { Encrypt(ctx.pk[0], 1, config.degree, params); }));
+    results.push_back(Measure("decrypt", config, 1, [&] { Decrypt(combined, c0); }));
+    results.push_back(Measure("evaluate_add", config, 1, [&] { EvaluateAdd(c0, c1); }));
+    results.push_back(Measure("evaluate_mult", config, 1, [&] { EvaluateMult(c0, c1); }));
+    results.push_back(Measure("combine_keys", config, 1, [&] { CombinedKey(ctx, all_parties); }));
+
+    const std::vector<int> messages(1024, 1);
+    results.push_back(Measure("encrypt_batch", config, messages.size(),
+                              [&] { EncryptBatch(ctx.pk[0], messages, config.degree, params); }));
+    const std::vector<Poly> batch = EncryptBatch(ctx.pk[0], messages, config.degree, params);
+    const DecryptionKey key = PrecomputeDecryptionKey(combined);
+    results.push_back(Measure("decrypt_batch", config, batch.size(), [&] { DecryptBatch(key, batch); }));
+
+    // ストリーミング集計: 全ユーザの 1ビットずつを threads 個のワーカーで暗号化して足す
+    std::vector<StreamItem> stream_items(messages.size());
+    for (size_t i = 0; i < stream_items.size(); ++i) {
+        stream_items[i] = {static_cast<unsigned int>(i % config.parties), static_cast<int>(i & 1)};
+    }
+    StreamConfig stream_config;
+    stream_config.workers = static_cast<unsigned int>(config.threads);
+    uint64_t steals = 0;
+    BenchResult stream = Measure("stream_aggregate", config, stream_items.size(), [&] {
+        StreamPipeline pipeline(ctx.pk, params, stream_config);
+        pipeline.Push(stream_items);
+        pipeline.FinishAndDecrypt(key);
+        steals += pipeline.Stats().steals.load();
+    });
+    stream.extra.emplace_back("steals_per_op", static_cast<double>(steals) / (config.iterations + 1));
+    results.push_back(stream);
+
+    // 多段の回路: 4ビットの桁上げ先見加算器 (入力はユーザに順に割り当てる)
+    std::vector<EvalKey> evks;
+    for (unsigned int party = 0; party < config.parties; ++party) {
+        evks.push_back(EvalKeyGen(ctx.sk[party], ctx.pk[party], config.degree, params));
+    }
+    Circuit circuit;
+    std::vector<size_t> a = AddInputs(circuit, 4), b = AddInputs(circuit, 4);
+    circuit.outputs = CarryLookaheadAdder(circuit, a, b);
+    std::vector<MKCiphertext> inputs;
+    for (size_t i = 0; i < circuit.num_inputs; ++i) {
+        const unsigned int party = static_cast<unsigned int>(i % config.parties);
+        inputs.push_back(EncryptMK(ctx.pk[party], party, static_cast<int>(i & 1), config.degree, params));
+    }
+    const CircuitOps ops = MakeCircuitOps(evks);
+    BenchResult adder = Measure("circuit_cla_adder_4bit", config, 1, [&] { EvaluateCircuit(circuit, inputs, ops); });
+    adder.extra.emplace_back("gates", static_cast<double>(circuit.gates.size()));
+    adder.extra.emplace_back("multiplicative_depth", static_cast<double>(MultiplicativeDepth(circuit)));
+    results.push_back(adder);
+}
+
+static std::vector<unsigned int> ParseList(const std::string& value) {
+    std::vector<unsigned int> list;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        list.push_back(static_cast<unsigned int>(std::stoul(item)));
+    }
+    return list;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<unsigned int> degrees = {8, 1024, 4096};
+    std::vector<unsigned int> bits = {30, 50};
+    std::vector<unsigned int> parties = {2, 4};
+    std::vector<unsigned int> threads = {1, static_cast<unsigned int>(omp_get_max_threads())};
+    size_t iterations = 100;
+    std::string out_path;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const size_t eq = arg.find('=');
+        const std::string key = arg.substr(0, eq);
+        const std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--degree") {
+            degrees = ParseList(value);
+        } else if (key == "--bits") {
+            bits = ParseList(value);
+        } else if (key == "--parties") {
+            parties = ParseList(value);
+        } else if (key == "--threads") {
+            threads = ParseList(value);
+        } else if (key == "--iterations") {
+            iterations = std::stoul(value);
+        } else if (key == "--out") {
+            out_path = value;
+        } else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--degree=8,1024] [--bits=30,50] [--parties=2,4] [--threads=1,8] [--iterations=100] [--out=file]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    // 重複を除く (指定の順は保つ)
+    std::vector<unsigned int> unique_threads;
+    for (unsigned int t : threads) {
+        if (std::find(unique_threads.begin(), unique_threads.end(), t) == unique_threads.end()) {
+            unique_threads.push_back(t);
+        }
+    }
+    threads = std::move(unique_threads);
+
+    std::vector<BenchResult> results;
+    for (unsigned int degree : degrees) {
+        for (unsigned int b : bits) {
+            for (unsigned int p : parties) {
+                for (unsigned int t : threads) {
+                    std::cerr << "degree=" << degree << " bits=" << b << " parties=" << p << " threads=" << t << std::endl;
+                    RunConfig({degree, b, std::max(p, 1u), static_cast<int>(t), std::max<size_t>(iterations, 1)}, results);
+                }
+            }
+        }
+    }
+
+    if (out_path.empty()) {
+        WriteJson(std::cout, results);
+    } else {
+        std::ofstream out(out_path);
+        WriteJson(out, results);
+    }
+    return 0;
+}
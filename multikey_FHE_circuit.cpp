@@ -0,0 +1,247 @@
+#include "multikey_FHE_circuit.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+size_t AddInput(Circuit& circuit) {
+    Gate gate;
+    gate.type = GATE_INPUT;
+    gate.value = static_cast<int>(circuit.num_inputs++);
+    circuit.gates.push_back(gate);
+    return circuit.gates.size() - 1;
+}
+
+std::vector<size_t> AddInputs(Circuit& circuit, size_t count) {
+    std::vector<size_t> ids;
+    for (size_t i = 0; i < count; ++i) {
+        ids.push_back(AddInput(circuit));
+    }
+    return ids;
+}
+
+size_t AddConstant(Circuit& circuit, int bit) {
+    Gate gate;
+    gate.type = GATE_CONSTANT;
+    gate.value = bit & 1;
+    circuit.gates.push_back(gate);
+    return circuit.gates.size() - 1;
+}
+
+size_t AddGate(Circuit& circuit, GateType type, size_t a, size_t b) {
+    if (type != GATE_ADD && type != GATE_MULT) {
+        throw std::invalid_argument("AddGate: only ADD and MULT gates take operands");
+    }
+    if (a >= circuit.gates.size() || b >= circuit.gates.size()) {
+        throw std::out_of_range("AddGate: operand does not exist");
+    }
+    Gate gate;
+    gate.type = type;
+    gate.a = a;
+    gate.b = b;
+    circuit.gates.push_back(gate);
+    return circuit.gates.size() - 1;
+}
+
+size_t Xor(Circuit& circuit, size_t a, size_t b) {
+    return AddGate(circuit, GATE_ADD, a, b);
+}
+
+size_t And(Circuit& circuit, size_t a, size_t b) {
+    return AddGate(circuit, GATE_MULT, a, b);
+}
+
+size_t Not(Circuit& circuit, size_t a) {
+    return Xor(circuit, a, AddConstant(circuit, 1));
+}
+
+size_t Or(Circuit& circuit, size_t a, size_t b) {
+    return Xor(circuit, Xor(circuit, a, b), And(circuit, a, b));
+}
+
+size_t MultiplicativeDepth(const Circuit& circuit) {
+    std::vector<size_t> depth(circuit.gates.size(), 0);
+    size_t result = 0;
+    for (size_t i = 0; i < circuit.gates.size(); ++i) {
+        const Gate& gate = circuit.gates[i];
+        if (gate.type == GATE_ADD || gate.type == GATE_MULT) {
+            depth[i] = std::max(depth[gate.a], depth[gate.b]) + (gate.type == GATE_MULT ? 1 : 0);
+        }
+    }
+    for (size_t output : circuit.outputs) {
+        result = std::max(result, depth.at(output));
+    }
+    return result;
+}
+
+CircuitOps MakeCircuitOps(const std::vector<EvalKey>& evks) {
+    // evks は参照で持つので、評価が終わるまで生かしておくこと
+    CircuitOps ops;
+    ops.add = [](const MKCiphertext& a, const MKCiphertext& b) { return EvaluateAdd(a, b); };
+    ops.mult = [&evks](const MKCiphertext& a, const MKCiphertext& b) { return EvaluateMult(a, b, evks); };
+    return ops;
+}
+
+std::vector<MKCiphertext> EvaluateCircuit(const Circuit& circuit, const std::vector<MKCiphertext>& inputs, const CircuitOps& ops) {
+    const size_t n = circuit.gates.size();
+    if (inputs.size() != circuit.num_inputs) {
+        throw std::invalid_argument("EvaluateCircuit: wrong number of inputs");
+    }
+
+    // 段 (入力からの最長距離) と、各ゲートの値を使う残りの回数
+    std::vector<size_t> level(n, 0);
+    std::vector<size_t> uses(n, 0);
+    std::vector<std::vector<size_t>> levels(1);
+    for (size_t i = 0; i < n; ++i) {
+        const Gate& gate = circuit.gates[i];
+        if (gate.type == GATE_ADD || gate.type == GATE_MULT) {
+            if (gate.a >= i || gate.b >= i) {
+                throw std::invalid_argument("EvaluateCircuit: gates are not in topological order");
+            }
+            level[i] = std::max(level[gate.a], level[gate.b]) + 1;
+            ++uses[gate.a];
+            ++uses[gate.b];
+        } else if (gate.type == GATE_CONSTANT && inputs.empty()) {
+            throw std::invalid_argument("EvaluateCircuit: constants need at least one input to take parameters from");
+        }
+        if (level[i] >= levels.size()) {
+            levels.resize(level[i] + 1);
+        }
+        levels[level[i]].push_back(i);
+    }
+    for (size_t output : circuit.outputs) {
+        ++uses.at(output); // 出力は最後まで解放しない
+    }
+
+    std::vector<MKCiphertext> values(n);
+    for (const std::vector<size_t>& gates : levels) {
+#pragma omp parallel for schedule(dynamic)
+        for (size_t k = 0; k < gates.size(); ++k) {
+            const size_t i = gates[k];
+            const Gate& gate = circuit.gates[i];
+            switch (gate.type) {
+                case GATE_INPUT:
+                    values[i] = inputs[gate.value];
+                    break;
+                case GATE_CONSTANT:
+                    values[i] = EncryptConstant(gate.value, inputs[0].c.GetParams());
+                    break;
+                case GATE_ADD:
+                    values[i] = ops.add(values[gate.a], values[gate.b]);
+                    break;
+                case GATE_MULT:
+                    values[i] = ops.mult(values[gate.a], values[gate.b]);
+                    break;
+            }
+        }
+
+        // この段で使い終わった値を解放する
+        for (size_t i : gates) {
+            const Gate& gate = circuit.gates[i];
+            if (gate.type == GATE_ADD || gate.type == GATE_MULT) {
+                if (--uses[gate.a] == 0) {
+                    values[gate.a] = MKCiphertext();
+                }
+                if (--uses[gate.b] == 0) {
+                    values[gate.b] = MKCiphertext();
+                }
+            }
+            if (uses[i] == 0) {
+                values[i] = MKCiphertext(); // どこからも使われないゲート
+            }
+        }
+    }
+
+    std::vector<MKCiphertext> outputs;
+    outputs.reserve(circuit.outputs.size());
+    for (size_t output : circuit.outputs) {
+        outputs.push_back(values[output]);
+    }
+    return outputs;
+}
+
+static void CheckOperands(const std::vector<size_t>& a, const std::vector<size_t>& b) {
+    if (a.empty() || a.size() != b.size()) {
+        throw std::invalid_argument("operands must be non-empty and have the same width");
+    }
+}
+
+// 桁上げ c' = ab + c(a+b) の2項は同時に 1 にならないので、OR ではなく XOR で足せる
+std::vector<size_t> RippleCarryAdder(Circuit& circuit, const std::vector<size_t>& a, const std::vector<size_t>& b) {
+    CheckOperands(a, b);
+    std::vector<size_t> sum;
+    size_t carry = And(circuit, a[0], b[0]);
+    sum.push_back(Xor(circuit, a[0], b[0]));
+    for (size_t i = 1; i < a.size(); ++i) {
+        size_t p = Xor(circuit, a[i], b[i]);
+        sum.push_back(Xor(circuit, p, carry));
+        carry = Xor(circuit, And(circuit, a[i], b[i]), And(circuit, p, carry));
+    }
+    sum.push_back(carry);
+    return sum;
+}
+
+// 生成 g_i = a_i b_i と伝播 p_i = a_i + b_i をプレフィックスで結合する:
+//   (G, P)[i] <- (G[i] + P[i] G[i-d], P[i] P[i-d])  (d = 1, 2, 4, ...)
+// 最後に G[i] は i ビット目から出る桁上げになる
+std::vector<size_t> CarryLookaheadAdder(Circuit& circuit, const std::vector<size_t>& a, const std::vector<size_t>& b) {
+    CheckOperands(a, b);
+    const size_t n = a.size();
+    std::vector<size_t> p(n), generate(n), propagate(n);
+    for (size_t i = 0; i < n; ++i) {
+        p[i] = Xor(circuit, a[i], b[i]);
+        generate[i] = And(circuit, a[i], b[i]);
+    }
+    propagate = p;
+    for (size_t d = 1; d < n; d *= 2) {
+        std::vector<size_t> next_generate = generate, next_propagate = propagate;
+        for (size_t i = d; i < n; ++i) {
+            next_generate[i] = Xor(circuit, generate[i], And(circuit, propagate[i], generate[i - d]));
+            // 次の段で P[i] を使うのは i >= 2d のときだけ
+            if (i >= 2 * d) {
+                next_propagate[i] = And(circuit, propagate[i], propagate[i - d]);
+            }
+        }
+        generate = std::move(next_generate);
+        propagate = std::move(next_propagate);
+    }
+
+    std::vector<size_t> sum;
+    sum.push_back(p[0]);
+    for (size_t i = 1; i < n; ++i) {
+        sum.push_back(Xor(circuit, p[i], generate[i - 1]));
+    }
+    sum.push_back(generate[n - 1]);
+    return sum;
+}
+
+// 下位ビットから lt' = (NOT a_i) b_i + (a_i == b_i) lt (2項は同時に 1 にならない)
+size_t LessThan(Circuit& circuit, const std::vector<size_t>& a, const std::vector<size_t>& b) {
+    CheckOperands(a, b);
+    size_t lt = And(circuit, Not(circuit, a[0]), b[0]);
+    for (size_t i = 1; i < a.size(); ++i) {
+        size_t differs = And(circuit, Not(circuit, a[i]), b[i]);
+        size_t same = Not(circuit, Xor(circuit, a[i], b[i]));
+        lt = Xor(circuit, differs, And(circuit, same, lt));
+    }
+    return lt;
+}
+
+size_t Equal(Circuit& circuit, const std::vector<size_t>& a, const std::vector<size_t>& b) {
+    CheckOperands(a, b);
+    std::vector<size_t> terms;
+    for (size_t i = 0; i < a.size(); ++i) {
+        terms.push_back(Not(circuit, Xor(circuit, a[i], b[i])));
+    }
+    while (terms.size() > 1) {
+        std::vector<size_t> next;
+        for (size_t i = 0; i + 1 < terms.size(); i += 2) {
+            next.push_back(And(circuit, terms[i], terms[i + 1]));
+        }
+        if (terms.size() % 2 == 1) {
+            next.push_back(terms.back());
+        }
+        terms = std::move(next);
+    }
+    return terms[0];
+}
@@ -0,0 +1,67 @@
+#ifndef MULTIKEY_FHE_CIRCUIT_H
+#define MULTIKEY_FHE_CIRCUIT_H
+
+#include "multikey_FHE_relin.h"
+#include <functional>
+
+// ブール回路 (mod 2 の算術回路) の DAG
+// ゲートは追加した順に番号が付き、入力は常に自分より前のゲートを指す (追加順が位相順)。
+// XOR = ADD、AND = MULT、NOT(x) = x + 1。ビット列はすべて下位ビットが先頭。
+enum GateType {
+    GATE_INPUT,    // value 番目の入力
+    GATE_CONSTANT, // 定数 value (0 か 1)
+    GATE_ADD,
+    GATE_MULT
+};
+
+struct Gate {
+    GateType type;
+    size_t a = 0;
+    size_t b = 0;
+    int value = 0;
+};
+
+struct Circuit {
+    std::vector<Gate> gates;
+    std::vector<size_t> outputs;
+    size_t num_inputs = 0;
+};
+
+size_t AddInput(Circuit& circuit);
+std::vector<size_t> AddInputs(Circuit& circuit, size_t count);
+size_t AddConstant(Circuit& circuit, int bit);
+size_t AddGate(Circuit& circuit, GateType type, size_t a, size_t b);
+size_t Xor(Circuit& circuit, size_t a, size_t b);
+size_t And(Circuit& circuit, size_t a, size_t b);
+size_t Not(Circuit& circuit, size_t a);
+// a OR b = a + b + ab
+size_t Or(Circuit& circuit, size_t a, size_t b);
+
+// 乗算の深さ (雑音の見積もり・法の段数を決めるのに使う)
+size_t MultiplicativeDepth(const Circuit& circuit);
+
+// 評価に使う同型演算 (EvaluateAdd / EvaluateMult を evks や ModulusChain ごと包んで渡す)
+// 同じ段のゲートは並列に呼ばれるので、スレッドセーフであること
+struct CircuitOps {
+    std::function<MKCiphertext(const MKCiphertext&, const MKCiphertext&)> add;
+    std::function<MKCiphertext(const MKCiphertext&, const MKCiphertext&)> mult;
+};
+
+CircuitOps MakeCircuitOps(const std::vector<EvalKey>& evks);
+
+// 回路の評価
+// ゲートを入力からの段数で分け、段ごとに OpenMP で並列に評価する。
+// 各ゲートの値は最後の利用者の段が終わった時点で解放するので、メモリは回路の幅で抑えられる。
+std::vector<MKCiphertext> EvaluateCircuit(const Circuit& circuit, const std::vector<MKCiphertext>& inputs, const CircuitOps& ops);
+
+// ---- ライブラリ回路 ----
+// n ビットの和 (n+1 ビット)。桁上げを順に伝える (乗算の深さ n)
+std::vector<size_t> RippleCarryAdder(Circuit& circuit, const std::vector<size_t>& a, const std::vector<size_t>& b);
+// 桁上げ先見加算器 (Kogge-Stone の並列プレフィックス、乗算の深さ ceil(log2 n) + 1)
+std::vector<size_t> CarryLookaheadAdder(Circuit& circuit, const std::vector<size_t>& a, const std::vector<size_t>& b);
+// 符号なし比較 a < b
+size_t LessThan(Circuit& circuit, const std::vector<size_t>& a, const std::vector<size_t>& b);
+// a == b (XNOR の積を木で求める)
+size_t Equal(Circuit& circuit, const std::vector<size_t>& a, const std::vector<size_t>& b);
+
+#endif
@@ -0,0 +1,117 @@
+#include "multikey_FHE_dcrt.h"
+#include "multikey_FHE_sampler.h"
+#include <stdexcept>
+
+using namespace std;
+
+std::shared_ptr<DCRTParams> GenerateDCRTParams(unsigned int degree, unsigned int numTowers, unsigned int towerBits) {
+    if (numTowers == 0 || towerBits > 60) {
+        throw std::invalid_argument("GenerateDCRTParams: need at least one tower of at most 60 bits");
+    }
+    const unsigned int cyclotomic_order = 2 * degree;
+    std::vector<NativeInteger> moduli(numTowers);
+    std::vector<NativeInteger> roots(numTowers);
+
+    moduli[0] = lbcrypto::LastPrime<NativeInteger>(towerBits, cyclotomic_order);
+    for (unsigned int i = 1; i < numTowers; ++i) {
+        moduli[i] = lbcrypto::PreviousPrime<NativeInteger>(moduli[i - 1], cyclotomic_order);
+    }
+    // 各タワーの原始根は独立に求められる
+#pragma omp parallel for
+    for (unsigned int i = 0; i < numTowers; ++i) {
+        roots[i] = RootOfUnity<NativeInteger>(cyclotomic_order, moduli[i]);
+    }
+    return std::make_shared<DCRTParams>(cyclotomic_order, moduli, roots);
+}
+
+// 「小さい」係数の多項式を生成 (同じ整数係数を全タワーに埋め込む)
+DCRTPoly GenerateSmallPoly(unsigned int degree, std::shared_ptr<DCRTParams> params) {
+    switch (GetSmallPolyDistribution()) {
+        case TERNARY:
+            return DCRTPoly(GetTernarySampler(), params, COEFFICIENT);
+        case BINARY:
+            return DCRTPoly(GetBinarySampler(), params, COEFFICIENT);
+        default:
+            return DCRTPoly(GetGaussianSampler(GetSmallPolySigma()), params, COEFFICIENT);
+    }
+}
+
+// 鍵生成 (NativePoly 版と同じ手順)
+bool KeyGen(unsigned int degree, std::shared_ptr<DCRTParams> params, DCRTPoly& sk, DCRTPoly& pk) {
+    DCRTPoly f_prime = GenerateSmallPoly(degree, params);
+    DCRTPoly g = GenerateSmallPoly(degree, params);
+    DCRTPoly f = f_prime.Times(BigInteger(2)).Plus(BigInteger(1));
+
+    try {
+        // SwitchFormat はタワーごとに OpenMP で並列に NTT される
+        f.SwitchFormat();
+        g.SwitchFormat();
+
+        // どれか1つのタワーで逆元がなければ再試行
+        if (!f.InverseExists()) {
+            return false;
+        }
+        DCRTPoly f_inv = f.MultiplicativeInverse();
+
+        sk = f;
+        pk = g.Times(BigInteger(2)) * f_inv;
+        return true;
+    } catch (const std::exception& e) {
+        return false;
+    }
+}
+
+// 暗号化
+// 定数 m の NTT は全スロットが m なので、評価形式のまま定数を足せば変換は不要
+DCRTPoly Encrypt(const DCRTPoly& pk, int message, unsigned int degree, std::shared_ptr<DCRTParams> params) {
+    DCRTPoly s = GenerateSmallPoly(degree, params);
+    DCRTPoly e = GenerateSmallPoly(degree, params);
+    s.SwitchFormat();
+    e.SwitchFormat();
+    DCRTPoly c = pk * s + e.Times(BigInteger(2));
+    return c.Plus(BigInteger(message & 1));
+}
+
+// 復号
+// 各タワーの定数項 a_i = mu[0] mod q_i から CRT で mu[0] mod Q を復元してパリティを取る
+//   mu[0] = Σ [a_i * (Q/q_i)^{-1}]_{q_i} * (Q/q_i)  mod Q
+// a_i は ConstantTerm (評価形式の内積) で求めるので、積も逆 NTT も作らない
+int Decrypt(const DCRTPoly& sk_combined, const DCRTPoly& c) {
+    auto params = c.GetParams();
+    const BigInteger& Q = params->GetModulus();
+    const size_t towers = c.GetNumOfElements();
+
+    std::vector<BigInteger> terms(towers);
+#pragma omp parallel for
+    for (size_t i = 0; i < towers; ++i) {
+        const NativeInteger& qi = params->GetParams()[i]->GetModulus();
+        BigInteger qi_big(qi.ConvertToInt());
+        BigInteger Qi = Q / qi_big;
+        NativeInteger Qi_mod_qi(Qi.Mod(qi_big).ConvertToInt());
+        NativeInteger a_i = ConstantTerm(c.GetElementAtIndex(i), sk_combined.GetElementAtIndex(i));
+        NativeInteger a = a_i.ModMul(Qi_mod_qi.ModInverse(qi), qi);
+        terms[i] = BigInteger(a.ConvertToInt()) * Qi;
+    }
+
+    BigInteger constant_term(0);
+    for (size_t i = 0; i < towers; ++i) {
+        constant_term = (constant_term + terms[i]).Mod(Q);
+    }
+
+    // Q は奇数なので、中心化 (x - Q) するとパリティが反転する
+    int parity = constant_term.Mod(BigInteger(2)).ConvertToInt();
+    if (constant_term > (Q >> 1)) {
+        parity ^= 1;
+    }
+    return parity;
+}
+
+// 同型加算
+DCRTPoly EvaluateAdd(const DCRTPoly& c1, const DCRTPoly& c2) {
+    return c1 + c2;
+}
+
+// 同型乗算
+DCRTPoly EvaluateMult(const DCRTPoly& c1, const DCRTPoly& c2) {
+    return c1 * c2;
+}
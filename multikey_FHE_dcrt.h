@@ -0,0 +1,23 @@
+#ifndef MULTIKEY_FHE_DCRT_H
+#define MULTIKEY_FHE_DCRT_H
+
+#include "multikey_FHE.h"
+
+// RNS (DCRTPoly) 版のバックエンド
+// 複数の 50〜60 ビット素数 q_i の積 Q を法とし、各タワー (mod q_i) を独立に計算する。
+// NativePoly 版と同じ名前のオーバーロードとして KeyGen/Encrypt/Decrypt/Evaluate* を提供する。
+using lbcrypto::DCRTPoly;
+using lbcrypto::BigInteger;
+using DCRTParams = lbcrypto::ILDCRTParams<BigInteger>;
+
+// 2*degree を割り切る (q_i ≡ 1 mod 2*degree) towerBits ビットの素数を numTowers 個選ぶ
+std::shared_ptr<DCRTParams> GenerateDCRTParams(unsigned int degree, unsigned int numTowers, unsigned int towerBits);
+
+DCRTPoly GenerateSmallPoly(unsigned int degree, std::shared_ptr<DCRTParams> params);
+bool KeyGen(unsigned int degree, std::shared_ptr<DCRTParams> params, DCRTPoly& sk, DCRTPoly& pk);
+DCRTPoly Encrypt(const DCRTPoly& pk, int message, unsigned int degree, std::shared_ptr<DCRTParams> params);
+int Decrypt(const DCRTPoly& sk_combined, const DCRTPoly& c);
+DCRTPoly EvaluateAdd(const DCRTPoly& c1, const DCRTPoly& c2);
+DCRTPoly EvaluateMult(const DCRTPoly& c1, const DCRTPoly& c2);
+
+#endif
@@ -0,0 +1,345 @@
+#ifndef MULTIKEY_FHE_FIXED_H
+#define MULTIKEY_FHE_FIXED_H
+
+#include "multikey_FHE_sampler.h"
+#include <array>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+
+// 次数と法をコンパイル時に固定した多項式
+// 小さい環 (N = 8, q = 320417 など) では NativePoly のヒープ上のベクトル、shared_ptr<ILNativeParams> の
+// 参照カウント、実行時の分岐のほうが演算より重い。FixedPoly<N, Q> は係数をスタック上の std::array に持ち、
+// 回転因子の表を constexpr で作り、N が定数なのでループは展開される。
+// KeyGen / Encrypt / Decrypt / EvaluateAdd / EvaluateMult は Poly 版と同じ名前で呼べる (params 引数はない)。
+// 評価形式のスロットはビット反転順 (スロットごとの演算と ConstantTerm にしか使わないので順序は関係ない)。
+
+namespace fixed_detail {
+
+template <uint64_t Q>
+constexpr uint64_t MulMod(uint64_t a, uint64_t b) {
+    if constexpr (Q < (uint64_t(1) << 32)) {
+        return a * b % Q;
+    } else {
+        return static_cast<uint64_t>(static_cast<unsigned __int128>(a) * b % Q);
+    }
+}
+
+template <uint64_t Q>
+constexpr uint64_t PowMod(uint64_t a, uint64_t e) {
+    uint64_t result = 1;
+    for (a %= Q; e > 0; e >>= 1) {
+        if (e & 1) {
+            result = MulMod<Q>(result, a);
+        }
+        a = MulMod<Q>(a, a);
+    }
+    return result;
+}
+
+// 決定的 Miller-Rabin (64 ビットの範囲で正しい底)
+template <uint64_t Q>
+constexpr bool IsPrime() {
+    if (Q < 2) {
+        return false;
+    }
+    constexpr uint64_t bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    uint64_t d = Q - 1;
+    unsigned int r = 0;
+    while ((d & 1) == 0) {
+        d >>= 1;
+        ++r;
+    }
+    for (uint64_t a : bases) {
+        if (a % Q == 0) {
+            continue;
+        }
+        uint64_t x = PowMod<Q>(a, d);
+        if (x == 1 || x == Q - 1) {
+            continue;
+        }
+        bool composite = true;
+        for (unsigned int i = 1; i < r && composite; ++i) {
+            x = MulMod<Q>(x, x);
+            composite = x != Q - 1;
+        }
+        if (composite) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 原始 2N 乗根 ψ (ψ^N = -1)
+template <size_t N, uint64_t Q>
+constexpr uint64_t FindRoot() {
+    for (uint64_t g = 2; g < Q; ++g) {
+        uint64_t psi = PowMod<Q>(g, (Q - 1) / (2 * N));
+        if (PowMod<Q>(psi, N) == Q - 1) {
+            return psi;
+        }
+    }
+    return 0;
+}
+
+constexpr size_t BitReverse(size_t x, size_t n) {
+    size_t result = 0;
+    for (size_t bit = 1; bit < n; bit <<= 1) {
+        result = (result << 1) | (x & 1);
+        x >>= 1;
+    }
+    return result;
+}
+
+// psi[i] = ψ^{bitrev(i)}, psi_inv[i] = ψ^{-bitrev(i)}
+template <size_t N, uint64_t Q>
+struct Twiddles {
+    std::array<uint64_t, N> psi{};
+    std::array<uint64_t, N> psi_inv{};
+    uint64_t n_inv = 0;
+};
+
+template <size_t N, uint64_t Q>
+constexpr Twiddles<N, Q> MakeTwiddles() {
+    Twiddles<N, Q> t;
+    const uint64_t root = FindRoot<N, Q>();
+    const uint64_t root_inv = PowMod<Q>(root, Q - 2);
+    for (size_t i = 0; i < N; ++i) {
+        t.psi[i] = PowMod<Q>(root, BitReverse(i, N));
+        t.psi_inv[i] = PowMod<Q>(root_inv, BitReverse(i, N));
+    }
+    t.n_inv = PowMod<Q>(N, Q - 2);
+    return t;
+}
+
+}  // namespace fixed_detail
+
+template <size_t N, uint64_t Q>
+struct FixedPoly {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "FixedPoly: N must be a power of two");
+    static_assert(Q < (uint64_t(1) << 62), "FixedPoly: Q must be below 2^62");
+    static_assert((Q - 1) % (2 * N) == 0, "FixedPoly: Q must be 1 mod 2N");
+    static_assert(fixed_detail::IsPrime<Q>(), "FixedPoly: Q must be prime");
+
+    static constexpr fixed_detail::Twiddles<N, Q> twiddles = fixed_detail::MakeTwiddles<N, Q>();
+
+    std::array<uint64_t, N> v{};
+    Format format = EVALUATION;
+
+    uint64_t& operator[](size_t i) { return v[i]; }
+    const uint64_t& operator[](size_t i) const { return v[i]; }
+    Format GetFormat() const { return format; }
+    static constexpr size_t GetRingDimension() { return N; }
+    static constexpr uint64_t GetModulus() { return Q; }
+
+    void SwitchFormat() {
+        if (format == COEFFICIENT) {
+            ForwardNTT();
+            format = EVALUATION;
+        } else {
+            InverseNTT();
+            format = COEFFICIENT;
+        }
+    }
+
+    // 負巡回 NTT (Cooley-Tukey、出力はビット反転順)
+    void ForwardNTT() {
+        size_t t = N;
+#pragma GCC unroll 16
+        for (size_t m = 1; m < N; m <<= 1) {
+            t >>= 1;
+            for (size_t i = 0; i < m; ++i) {
+                const uint64_t s = twiddles.psi[m + i];
+                const size_t j1 = 2 * i * t;
+#pragma GCC unroll 64
+                for (size_t j = j1; j < j1 + t; ++j) {
+                    const uint64_t x = v[j];
+                    const uint64_t y = fixed_detail::MulMod<Q>(v[j + t], s);
+                    v[j] = x + y >= Q ? x + y - Q : x + y;
+                    v[j + t] = x >= y ? x - y : x + Q - y;
+                }
+            }
+        }
+    }
+
+    // 逆変換 (Gentleman-Sande、入力はビット反転順)
+    void InverseNTT() {
+        size_t t = 1;
+#pragma GCC unroll 16
+        for (size_t m = N; m > 1; m >>= 1) {
+            const size_t h = m >> 1;
+            for (size_t i = 0; i < h; ++i) {
+                const uint64_t s = twiddles.psi_inv[h + i];
+                const size_t j1 = 2 * i * t;
+#pragma GCC unroll 64
+                for (size_t j = j1; j < j1 + t; ++j) {
+                    const uint64_t x = v[j];
+                    const uint64_t y = v[j + t];
+                    v[j] = x + y >= Q ? x + y - Q : x + y;
+                    v[j + t] = fixed_detail::MulMod<Q>(x >= y ? x - y : x + Q - y, s);
+                }
+            }
+            t <<= 1;
+        }
+#pragma GCC unroll 64
+        for (size_t j = 0; j < N; ++j) {
+            v[j] = fixed_detail::MulMod<Q>(v[j], twiddles.n_inv);
+        }
+    }
+
+    // スロットごとの演算 (評価形式)
+    FixedPoly& operator+=(const FixedPoly& other) {
+#pragma GCC unroll 64
+        for (size_t i = 0; i < N; ++i) {
+            const uint64_t s = v[i] + other.v[i];
+            v[i] = s >= Q ? s - Q : s;
+        }
+        return *this;
+    }
+
+    FixedPoly& operator*=(const FixedPoly& other) {
+#pragma GCC unroll 64
+        for (size_t i = 0; i < N; ++i) {
+            v[i] = fixed_detail::MulMod<Q>(v[i], other.v[i]);
+        }
+        return *this;
+    }
+
+    bool operator==(const FixedPoly& other) const { return format == other.format && v == other.v; }
+};
+
+template <size_t N, uint64_t Q>
+FixedPoly<N, Q> operator+(FixedPoly<N, Q> a, const FixedPoly<N, Q>& b) {
+    return a += b;
+}
+
+template <size_t N, uint64_t Q>
+FixedPoly<N, Q> operator*(FixedPoly<N, Q> a, const FixedPoly<N, Q>& b) {
+    return a *= b;
+}
+
+// 小さい多項式 (分布は SetSmallPolyDistribution の設定に従う。係数形式)
+template <size_t N, uint64_t Q>
+FixedPoly<N, Q> GenerateSmallFixedPoly() {
+    FixedPoly<N, Q> p;
+    p.format = COEFFICIENT;
+    const SmallDistribution distribution = GetSmallPolyDistribution();
+    if (distribution == GAUSSIAN) {
+        const auto& sampler = GetGaussianSampler(GetSmallPolySigma());
+        for (size_t i = 0; i < N; ++i) {
+            const int64_t x = sampler.GenerateInt();
+            p[i] = x < 0 ? Q - static_cast<uint64_t>(-x) : static_cast<uint64_t>(x);
+        }
+    } else {
+        auto& prng = lbcrypto::PseudoRandomNumberGenerator::GetPRNG();
+        std::uniform_int_distribution<int> dist(distribution == TERNARY ? -1 : 0, 1);
+        for (size_t i = 0; i < N; ++i) {
+            const int x = dist(prng);
+            p[i] = x < 0 ? Q - 1 : static_cast<uint64_t>(x);
+        }
+    }
+    return p;
+}
+
+// 鍵生成 (f = 2f'+1、h = 2g f^{-1})
+// 評価形式では逆元はスロットごとの逆数で、どれかのスロットが 0 なら存在しない
+template <size_t N, uint64_t Q>
+bool KeyGen(FixedPoly<N, Q>& sk, FixedPoly<N, Q>& pk) {
+    FixedPoly<N, Q> f = GenerateSmallFixedPoly<N, Q>();
+    FixedPoly<N, Q> g = GenerateSmallFixedPoly<N, Q>();
+    f += f;
+    f.SwitchFormat();
+    g.SwitchFormat();
+    FixedPoly<N, Q> h;
+    for (size_t i = 0; i < N; ++i) {
+        f[i] = f[i] + 1 == Q ? 0 : f[i] + 1; // 定数 1 は全スロットが 1
+        if (f[i] == 0) {
+            return false;
+        }
+        const uint64_t g2 = g[i] + g[i] >= Q ? g[i] + g[i] - Q : g[i] + g[i];
+        h[i] = fixed_detail::MulMod<Q>(g2, fixed_detail::PowMod<Q>(f[i], Q - 2));
+    }
+    sk = f;
+    pk = h;
+    return true;
+}
+
+template <size_t N, uint64_t Q>
+FixedPoly<N, Q> Encrypt(const FixedPoly<N, Q>& pk, int message) {
+    FixedPoly<N, Q> s = GenerateSmallFixedPoly<N, Q>();
+    FixedPoly<N, Q> e = GenerateSmallFixedPoly<N, Q>();
+    s.SwitchFormat();
+    e.SwitchFormat();
+    const uint64_t m = static_cast<uint64_t>(message & 1);
+    FixedPoly<N, Q> c;
+#pragma GCC unroll 64
+    for (size_t i = 0; i < N; ++i) {
+        c[i] = (fixed_detail::MulMod<Q>(pk[i], s[i]) + 2 * e[i] + m) % Q;
+    }
+    return c;
+}
+
+// 定数項 = N^{-1} Σ ĉ_i F̂_i (ConstantTerm と同じく逆 NTT なし)
+template <size_t N, uint64_t Q>
+int Decrypt(const FixedPoly<N, Q>& sk_combined, const FixedPoly<N, Q>& c) {
+    uint64_t sum = 0;
+#pragma GCC unroll 64
+    for (size_t i = 0; i < N; ++i) {
+        sum += fixed_detail::MulMod<Q>(c[i], sk_combined[i]);
+        sum = sum >= Q ? sum - Q : sum;
+    }
+    sum = fixed_detail::MulMod<Q>(sum, FixedPoly<N, Q>::twiddles.n_inv);
+    return CenteredParity(NativeInteger(sum), static_cast<int64_t>(Q));
+}
+
+template <size_t N, uint64_t Q>
+FixedPoly<N, Q> EvaluateAdd(const FixedPoly<N, Q>& c1, const FixedPoly<N, Q>& c2) {
+    return c1 + c2;
+}
+
+template <size_t N, uint64_t Q>
+FixedPoly<N, Q> EvaluateMult(const FixedPoly<N, Q>& c1, const FixedPoly<N, Q>& c2) {
+    return c1 * c2;
+}
+
+// NativePoly との相互変換 (係数形式を経由する。params は次数 N・法 Q でなければならない)
+template <size_t N, uint64_t Q>
+Poly ToPoly(FixedPoly<N, Q> p, std::shared_ptr<ILNativeParams> params) {
+    if (params->GetRingDimension() != N || params->GetModulus() != NativeInteger(Q)) {
+        throw std::invalid_argument("ToPoly: params do not match FixedPoly<N, Q>");
+    }
+    const Format format = p.format;
+    if (format == EVALUATION) {
+        p.SwitchFormat();
+    }
+    Poly result(params, COEFFICIENT, true);
+    for (size_t i = 0; i < N; ++i) {
+        result[i] = NativeInteger(p[i]);
+    }
+    if (format == EVALUATION) {
+        result.SwitchFormat();
+    }
+    return result;
+}
+
+template <size_t N, uint64_t Q>
+FixedPoly<N, Q> FromPoly(Poly p) {
+    if (p.GetRingDimension() != N || p.GetModulus() != NativeInteger(Q)) {
+        throw std::invalid_argument("FromPoly: Poly does not match FixedPoly<N, Q>");
+    }
+    const Format format = p.GetFormat();
+    if (format == EVALUATION) {
+        p.SwitchFormat();
+    }
+    FixedPoly<N, Q> result;
+    result.format = COEFFICIENT;
+    for (size_t i = 0; i < N; ++i) {
+        result[i] = p[i].ConvertToInt();
+    }
+    if (format == EVALUATION) {
+        result.SwitchFormat();
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,159 @@
+#include "multikey_FHE_keypool.h"
+#include "multikey_FHE_serial.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <omp.h>
+
+using namespace std;
+
+void KeyGenSpeculative(unsigned int degree, std::shared_ptr<ILNativeParams> params, Poly& sk, Poly& pk, unsigned int candidates) {
+    if (candidates == 0) {
+        candidates = static_cast<unsigned int>(omp_get_max_threads());
+    }
+    bool found = false;
+    while (!found) {
+        int winner = -1;
+#pragma omp parallel for schedule(static)
+        for (int k = 0; k < static_cast<int>(candidates); ++k) {
+            Poly f, h;
+            if (!KeyGen(degree, params, f, h)) {
+                continue;
+            }
+            // 番号の小さい候補を優先する (どのスレッドが先に終わっても結果が決まる)
+#pragma omp critical
+            if (winner < 0 || k < winner) {
+                winner = k;
+                sk = std::move(f);
+                pk = std::move(h);
+            }
+        }
+        found = winner >= 0;
+    }
+}
+
+KeyPool::KeyPool(unsigned int degree, std::shared_ptr<ILNativeParams> params, size_t capacity)
+    : m_degree(degree), m_params(std::move(params)), m_capacity(capacity) {}
+
+KeyPool::~KeyPool() {
+    Stop();
+}
+
+void KeyPool::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_worker.joinable()) {
+        return;
+    }
+    m_stop = false;
+    m_worker = std::thread(&KeyPool::Run, this);
+}
+
+void KeyPool::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_changed.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+// 鍵の生成はロックの外で行い、溜めるときだけロックを取る
+void KeyPool::Run() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changed.wait(lock, [this] { return m_stop || m_keys.size() < m_capacity; });
+            if (m_stop) {
+                return;
+            }
+        }
+        Poly sk, pk;
+        while (!KeyGen(m_degree, m_params, sk, pk));
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_keys.emplace_back(std::move(sk), std::move(pk));
+        }
+        m_changed.notify_all();
+    }
+}
+
+void KeyPool::Acquire(Poly& sk, Poly& pk) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_keys.empty()) {
+            sk = std::move(m_keys.front().first);
+            pk = std::move(m_keys.front().second);
+            m_keys.pop_front();
+        } else {
+            sk = Poly();
+        }
+    }
+    m_changed.notify_all();
+    if (sk.IsEmpty()) {
+        KeyGenSpeculative(m_degree, m_params, sk, pk);
+    }
+}
+
+size_t KeyPool::Size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_keys.size();
+}
+
+void KeyPool::WaitUntil(size_t count) const {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_changed.wait(lock, [this, count] { return m_keys.size() >= count; });
+}
+
+// ファイル形式: "MKFHEKEY", 組の数 (uint64)、続けて各組の sk, pk を WritePoly の形式で
+// (係数は q のビット幅に詰め、評価形式のまま書くので読み込みで NTT しない)
+static const char KEY_FILE_MAGIC[8] = {'M', 'K', 'F', 'H', 'E', 'K', 'E', 'Y'};
+
+void KeyPool::Save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("KeyPool::Save: cannot open " + path);
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const uint64_t count = m_keys.size();
+    out.write(KEY_FILE_MAGIC, sizeof(KEY_FILE_MAGIC));
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (const auto& key : m_keys) {
+        WritePoly(out, key.first);
+        WritePoly(out, key.second);
+    }
+    if (!out) {
+        throw std::runtime_error("KeyPool::Save: write failed for " + path);
+    }
+}
+
+void KeyPool::Load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("KeyPool::Load: cannot open " + path);
+    }
+    char magic[sizeof(KEY_FILE_MAGIC)];
+    uint64_t count = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!in || std::memcmp(magic, KEY_FILE_MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error("KeyPool::Load: not a key file: " + path);
+    }
+
+    // ReadPoly が次数・法の不一致を検出する
+    std::vector<std::pair<Poly, Poly>> loaded;
+    for (uint64_t k = 0; k < count; ++k) {
+        Poly sk = ReadPoly(in, m_params);
+        Poly pk = ReadPoly(in, m_params);
+        loaded.emplace_back(std::move(sk), std::move(pk));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& key : loaded) {
+            m_keys.push_back(std::move(key));
+        }
+    }
+    m_changed.notify_all();
+}
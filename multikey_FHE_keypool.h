@@ -0,0 +1,50 @@
+#ifndef MULTIKEY_FHE_KEYPOOL_H
+#define MULTIKEY_FHE_KEYPOOL_H
+
+#include "multikey_FHE.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// 投機的な並列鍵生成
+// candidates 個 (0 なら OpenMP のスレッド数) の f を同時に引き、f が逆元を持った最初の候補を使う。
+// 全候補が失敗したときだけもう一度引くので、逐次の再試行より待ち時間のばらつきが小さい。
+void KeyGenSpeculative(unsigned int degree, std::shared_ptr<ILNativeParams> params, Poly& sk, Poly& pk, unsigned int candidates = 0);
+
+// 事前に生成した鍵の組 (sk, pk) を溜めておくプール
+// Start するとバックグラウンドのスレッドが capacity 組まで補充し続ける。
+// Acquire は溜まっていれば取り出すだけで、空のときはその場で KeyGenSpeculative を呼ぶ。
+class KeyPool {
+public:
+    KeyPool(unsigned int degree, std::shared_ptr<ILNativeParams> params, size_t capacity);
+    ~KeyPool();
+    KeyPool(const KeyPool&) = delete;
+    KeyPool& operator=(const KeyPool&) = delete;
+
+    void Start();
+    void Stop();
+    void Acquire(Poly& sk, Poly& pk);
+    size_t Size() const;
+    // 少なくとも count 組溜まるまで待つ (Start していないと返らない)
+    void WaitUntil(size_t count) const;
+
+    // ファイルへの保存と読み込み (読み込んだ鍵はプールに足す)
+    void Save(const std::string& path) const;
+    void Load(const std::string& path);
+
+private:
+    void Run();
+
+    unsigned int m_degree;
+    std::shared_ptr<ILNativeParams> m_params;
+    size_t m_capacity;
+    std::deque<std::pair<Poly, Poly>> m_keys;
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_changed;
+    std::thread m_worker;
+    bool m_stop = false;
+};
+
+#endif
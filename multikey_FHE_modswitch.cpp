@@ -0,0 +1,178 @@
+#include "multikey_FHE_modswitch.h"
+#include "multikey_FHE_noise.h"
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+using namespace std;
+
+ModulusChain GenerateModulusChain(unsigned int degree, const std::vector<unsigned int>& bits) {
+    const unsigned int cyclotomic_order = 2 * degree;
+    ModulusChain chain;
+    NativeInteger previous(0);
+    for (unsigned int b : bits) {
+        NativeInteger modulus = lbcrypto::LastPrime<NativeInteger>(b, cyclotomic_order);
+        // 同じビット数が続いたときも法が真に小さくなるようにする
+        if (previous != NativeInteger(0) && modulus >= previous) {
+            modulus = lbcrypto::PreviousPrime<NativeInteger>(previous, cyclotomic_order);
+        }
+        NativeInteger rootOfUnity = RootOfUnity<NativeInteger>(cyclotomic_order, modulus);
+        chain.levels.push_back(std::make_shared<ILNativeParams>(cyclotomic_order, modulus, rootOfUnity));
+        previous = modulus;
+    }
+    return chain;
+}
+
+// x を (-q/2, q/2] に中心化した値
+static int64_t Centered(const NativeInteger& x, uint64_t modulus) {
+    uint64_t value = x.ConvertToInt();
+    return value > modulus / 2 ? static_cast<int64_t>(value) - static_cast<int64_t>(modulus) : static_cast<int64_t>(value);
+}
+
+static NativeInteger FromCentered(int64_t x, uint64_t modulus) {
+    return x < 0 ? NativeInteger(modulus - static_cast<uint64_t>(-x)) : NativeInteger(static_cast<uint64_t>(x));
+}
+
+// round(x * to / from) のうち x と同じパリティのもの (誤差は 1 以下)
+static int64_t ScaleParityPreserving(int64_t x, uint64_t from, uint64_t to) {
+    __int128 num = static_cast<__int128>(x) * to;
+    __int128 y = num / from;
+    if (num % from != 0 && num < 0) {
+        y -= 1; // 床関数にそろえる
+    }
+    if (((y - x) & 1) != 0) {
+        y += 1;
+    }
+    return static_cast<int64_t>(y);
+}
+
+// 法の切り替え
+// c*F = m + 2E + qK のとき c' = (q'/q)c + ε (c' ≡ c mod 2) とすると
+// c'*F ≡ (q'/q)(m + 2E) + εF (mod q') で、q ≡ q' ≡ 1 (mod 2) ならパリティは m のまま
+Poly ModSwitch(const Poly& c, std::shared_ptr<ILNativeParams> to) {
+    Poly x = c;
+    const Format format = x.GetFormat();
+    if (format == EVALUATION) {
+        x.SwitchFormat();
+    }
+    const uint64_t from_modulus = x.GetModulus().ConvertToInt();
+    const uint64_t to_modulus = to->GetModulus().ConvertToInt();
+
+    Poly result(to, COEFFICIENT, true);
+    for (size_t i = 0; i < x.GetLength(); ++i) {
+        int64_t y = ScaleParityPreserving(Centered(x[i], from_modulus), from_modulus, to_modulus);
+        result[i] = FromCentered(y, to_modulus);
+    }
+    if (format == EVALUATION) {
+        result.SwitchFormat();
+    }
+    return result;
+}
+
+Poly SwitchKeyModulus(const Poly& small, std::shared_ptr<ILNativeParams> to) {
+    Poly x = small;
+    const Format format = x.GetFormat();
+    if (format == EVALUATION) {
+        x.SwitchFormat();
+    }
+    const uint64_t from_modulus = x.GetModulus().ConvertToInt();
+    const uint64_t to_modulus = to->GetModulus().ConvertToInt();
+
+    Poly result(to, COEFFICIENT, true);
+    for (size_t i = 0; i < x.GetLength(); ++i) {
+        result[i] = FromCentered(Centered(x[i], from_modulus), to_modulus);
+    }
+    if (format == EVALUATION) {
+        result.SwitchFormat();
+    }
+    return result;
+}
+
+// 鍵生成 (全段で同じ f', g を使う)
+bool KeyGen(unsigned int degree, const ModulusChain& chain, LeveledKeyPair& keys) {
+    Poly f_prime = GenerateSmallPoly(degree, chain.levels[0]);
+    Poly g = GenerateSmallPoly(degree, chain.levels[0]);
+
+    LeveledKeyPair result;
+    for (const auto& params : chain.levels) {
+        Poly f = SwitchKeyModulus(f_prime, params) * 2 + 1;
+        Poly g_level = SwitchKeyModulus(g, params);
+        try {
+            f.SwitchFormat();
+            g_level.SwitchFormat();
+            // どれか1つの段で逆元がなければ再試行
+            if (!f.InverseExists()) {
+                return false;
+            }
+            Poly f_inv = f.MultiplicativeInverse();
+            result.sk.push_back(f);
+            result.pk.push_back(g_level * 2 * f_inv);
+        } catch (const std::exception& e) {
+            return false;
+        }
+    }
+    keys = std::move(result);
+    return true;
+}
+
+std::vector<EvalKey> EvalKeyGen(const LeveledKeyPair& keys, unsigned int degree, const ModulusChain& chain, unsigned int baseBits) {
+    std::vector<EvalKey> evks;
+    for (size_t level = 0; level < chain.levels.size(); ++level) {
+        evks.push_back(EvalKeyGen(keys.sk[level], keys.pk[level], degree, chain.levels[level], baseBits));
+    }
+    return evks;
+}
+
+MKCiphertext ModSwitch(const MKCiphertext& ct, const ModulusChain& chain) {
+    if (ct.level + 1 >= chain.levels.size()) {
+        throw std::out_of_range("ModSwitch: ciphertext is already at the last level");
+    }
+    MKCiphertext result;
+    result.c = ModSwitch(ct.c, chain.levels[ct.level + 1]);
+    result.parties = ct.parties;
+    result.level = ct.level + 1;
+    result.noise = EstimateModSwitchNoise(ct, chain.levels[ct.level + 1]->GetModulus());
+    LogNoise("modswitch", result);
+    return result;
+}
+
+// 段をそろえる (低い段に合わせる)
+static MKCiphertext SwitchToLevel(const MKCiphertext& ct, unsigned int level, const ModulusChain& chain) {
+    MKCiphertext result = ct;
+    while (result.level < level) {
+        result = ModSwitch(result, chain);
+    }
+    return result;
+}
+
+MKCiphertext EvaluateAdd(const MKCiphertext& c1, const MKCiphertext& c2, const ModulusChain& chain) {
+    const unsigned int level = std::max(c1.level, c2.level);
+    return EvaluateAdd(SwitchToLevel(c1, level, chain), SwitchToLevel(c2, level, chain));
+}
+
+MKCiphertext EvaluateMult(const MKCiphertext& c1, const MKCiphertext& c2, const std::vector<std::vector<EvalKey>>& evks, const ModulusChain& chain) {
+    const unsigned int level = std::max(c1.level, c2.level);
+    MKCiphertext a = SwitchToLevel(c1, level, chain);
+    MKCiphertext b = SwitchToLevel(c2, level, chain);
+
+    MKCiphertext result;
+    result.c = EvaluateMult(a.c, b.c);
+    result.level = level;
+
+    std::vector<unsigned int> shared;
+    std::set_intersection(a.parties.begin(), a.parties.end(), b.parties.begin(), b.parties.end(),
+                          std::back_inserter(shared));
+    for (unsigned int party : shared) {
+        result.c = Relinearize(result.c, evks.at(party).at(level));
+    }
+    std::set_union(a.parties.begin(), a.parties.end(), b.parties.begin(), b.parties.end(),
+                   std::back_inserter(result.parties));
+    result.noise = EstimateMultNoise(a, b, shared.empty() ? 0 : evks.at(shared[0]).at(level).baseBits);
+    LogNoise("mult", result);
+
+    // 最後の段でなければ次の段に下げる
+    if (result.level + 1 < chain.levels.size()) {
+        result = ModSwitch(result, chain);
+    }
+    return result;
+}
@@ -0,0 +1,39 @@
+#ifndef MULTIKEY_FHE_MODSWITCH_H
+#define MULTIKEY_FHE_MODSWITCH_H
+
+#include "multikey_FHE_relin.h"
+
+// 法の段 (modulus ladder)
+// levels[0] が最大の法で、乗算のたびに次の小さい法へ ModSwitch する。
+// 法を q -> q' に下げると雑音もおよそ q'/q 倍になるので、雑音は深さに対して
+// 指数的ではなく線形に増える。
+struct ModulusChain {
+    std::vector<std::shared_ptr<ILNativeParams>> levels;
+};
+
+// bits[i] ビットの素数 (≡ 1 mod 2*degree) で段を作る。bits は降順で与える
+ModulusChain GenerateModulusChain(unsigned int degree, const std::vector<unsigned int>& bits);
+
+// c を round(c * q'/q) にスケールする。ただしパリティ (mod 2) は保存する
+Poly ModSwitch(const Poly& c, std::shared_ptr<ILNativeParams> to);
+// 小さい係数の多項式 (秘密鍵など) を中心化して別の法に埋め込み直す
+Poly SwitchKeyModulus(const Poly& small, std::shared_ptr<ILNativeParams> to);
+
+// 全段で同じ f, g を使った鍵 (sk[l], pk[l] は段 l の法)
+struct LeveledKeyPair {
+    std::vector<Poly> sk;
+    std::vector<Poly> pk;
+};
+
+bool KeyGen(unsigned int degree, const ModulusChain& chain, LeveledKeyPair& keys);
+// 段ごとの評価鍵 (戻り値[l] が段 l 用)
+std::vector<EvalKey> EvalKeyGen(const LeveledKeyPair& keys, unsigned int degree, const ModulusChain& chain, unsigned int baseBits = 4);
+
+// 暗号文を1段下げる
+MKCiphertext ModSwitch(const MKCiphertext& ct, const ModulusChain& chain);
+// 段が異なる場合は高い方 (法が大きい方) を下げてから演算する
+MKCiphertext EvaluateAdd(const MKCiphertext& c1, const MKCiphertext& c2, const ModulusChain& chain);
+// 乗算 -> 再線形化 -> ModSwitch。evks[i][l] はユーザ i の段 l の評価鍵
+MKCiphertext EvaluateMult(const MKCiphertext& c1, const MKCiphertext& c2, const std::vector<std::vector<EvalKey>>& evks, const ModulusChain& chain);
+
+#endif
@@ -0,0 +1,181 @@
+#include "multikey_FHE_noise.h"
+#include "multikey_FHE_sampler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+
+using namespace std;
+
+// 係数の分散を伝播させて見積もる。
+// 独立な係数を持つ多項式の積は、係数の分散が N * var(a) * var(b) になる。
+
+// f = 2f'+1 の係数の分散
+static double KeyVariance() {
+    return 4.0 * SmallPolyVariance();
+}
+
+// n 人分の鍵を掛けたときの係数の分散 (N^{n-1} * var(f)^n)
+static double KeyProductVariance(unsigned int degree, size_t n) {
+    if (n == 0) {
+        return 1.0;
+    }
+    return std::pow(static_cast<double>(degree), static_cast<double>(n - 1)) *
+           std::pow(KeyVariance(), static_cast<double>(n));
+}
+
+// 足りない n 人分の鍵を掛けたときに分散が何倍になるか
+static double ExtraKeyFactor(unsigned int degree, size_t n) {
+    return std::pow(degree * KeyVariance(), static_cast<double>(n));
+}
+
+// 2gs + 2ef の分散 (新しい暗号文・評価鍵の雑音)
+static double EncryptionVariance(unsigned int degree) {
+    const double small = SmallPolyVariance();
+    return 4.0 * degree * small * small + 4.0 * degree * small * KeyVariance();
+}
+
+double NoiseBound(const MKCiphertext& ct) {
+    return TAIL * ct.noise;
+}
+
+double FreshNoise(unsigned int degree) {
+    return std::sqrt(EncryptionVariance(degree));
+}
+
+double EstimateAddNoise(const MKCiphertext& c1, const MKCiphertext& c2) {
+    const unsigned int degree = c1.c.GetRingDimension();
+    std::vector<unsigned int> parties;
+    std::set_union(c1.parties.begin(), c1.parties.end(), c2.parties.begin(), c2.parties.end(),
+                   std::back_inserter(parties));
+    return std::sqrt(c1.noise * c1.noise * ExtraKeyFactor(degree, parties.size() - c1.parties.size()) +
+                     c2.noise * c2.noise * ExtraKeyFactor(degree, parties.size() - c2.parties.size()));
+}
+
+double EstimateSumNoise(const std::vector<MKCiphertext>& cts) {
+    if (cts.empty()) {
+        return 0;
+    }
+    const unsigned int degree = cts[0].c.GetRingDimension();
+    std::vector<unsigned int> parties;
+    for (const MKCiphertext& ct : cts) {
+        std::vector<unsigned int> merged;
+        std::set_union(parties.begin(), parties.end(), ct.parties.begin(), ct.parties.end(),
+                       std::back_inserter(merged));
+        parties = std::move(merged);
+    }
+    double variance = 0;
+    for (const MKCiphertext& ct : cts) {
+        variance += ct.noise * ct.noise * ExtraKeyFactor(degree, parties.size() - ct.parties.size());
+    }
+    return std::sqrt(variance);
+}
+
+double EstimateSumNoise(unsigned int degree, const std::vector<NoiseTerm>& terms) {
+    std::vector<unsigned int> parties;
+    for (const NoiseTerm& term : terms) {
+        if (term.count > 0) {
+            parties.push_back(term.party);
+        }
+    }
+    std::sort(parties.begin(), parties.end());
+    parties.erase(std::unique(parties.begin(), parties.end()), parties.end());
+    if (parties.empty()) {
+        return 0;
+    }
+    // 各暗号文には自分以外の parties.size() - 1 人分の鍵が掛かる
+    const double extra = ExtraKeyFactor(degree, parties.size() - 1);
+    double variance = 0;
+    for (const NoiseTerm& term : terms) {
+        variance += term.count * term.noise * term.noise * extra;
+    }
+    return std::sqrt(variance);
+}
+
+double EstimateMultNoise(const MKCiphertext& c1, const MKCiphertext& c2, unsigned int baseBits) {
+    const unsigned int degree = c1.c.GetRingDimension();
+
+    std::vector<unsigned int> parties, shared;
+    std::set_union(c1.parties.begin(), c1.parties.end(), c2.parties.begin(), c2.parties.end(),
+                   std::back_inserter(parties));
+    std::set_intersection(c1.parties.begin(), c1.parties.end(), c2.parties.begin(), c2.parties.end(),
+                          std::back_inserter(shared));
+
+    double variance = degree * c1.noise * c1.noise * c2.noise * c2.noise;
+    if (!shared.empty() && baseBits > 0) {
+        // 再線形化1回ごとに Σ_τ D_τ(c) (2 g s_τ + 2 e_τ f) * F_{S-p} が加わる
+        // 桁 D_τ は [0, 2^w) の一様分布とみなす (二乗平均 4^w / 3)
+        const unsigned int modulus_bits = c1.c.GetModulus().GetMSB();
+        const unsigned int digits = (modulus_bits + baseBits - 1) / baseBits;
+        const double digit_square = std::pow(4.0, baseBits) / 3.0;
+        const double relin_variance = digits * degree * digit_square * EncryptionVariance(degree) *
+                                      ExtraKeyFactor(degree, parties.size() - 1);
+        variance += relin_variance * shared.size();
+    }
+    return std::sqrt(variance);
+}
+
+double EstimateModSwitchNoise(const MKCiphertext& ct, const NativeInteger& to_modulus) {
+    const unsigned int degree = ct.c.GetRingDimension();
+    const double ratio = to_modulus.ConvertToDouble() / ct.c.GetModulus().ConvertToDouble();
+    // 丸め誤差 ε ∈ [-1, 1] (分散 1/3) に合成鍵 F_S が掛かる
+    const double scaled = ct.noise * ratio;
+    return std::sqrt(scaled * scaled + degree * KeyProductVariance(degree, ct.parties.size()) / 3.0);
+}
+
+double NoiseBudget(const MKCiphertext& ct) {
+    const double half_modulus = ct.c.GetModulus().ConvertToDouble() / 2.0;
+    return std::log2(half_modulus) - std::log2(std::max(NoiseBound(ct), 1.0));
+}
+
+bool CanMultiply(const MKCiphertext& c1, const MKCiphertext& c2, unsigned int baseBits) {
+    MKCiphertext estimate;
+    estimate.c = c1.c;
+    estimate.noise = EstimateMultNoise(c1, c2, baseBits);
+    return NoiseBudget(estimate) > 0;
+}
+
+// ---- デバッグモード ----
+
+static std::vector<std::vector<Poly>> debug_keys;
+static std::mutex debug_mutex;
+// デバッグモードでないときは LogNoise がロックを取らずに返れるようにする
+static std::atomic<bool> debug_enabled{false};
+
+void SetNoiseDebugKeys(const std::vector<std::vector<Poly>>& keys) {
+    std::lock_guard<std::mutex> lock(debug_mutex);
+    debug_keys = keys;
+    debug_enabled.store(!debug_keys.empty(), std::memory_order_release);
+}
+
+double MeasureNoise(const MKCiphertext& ct, const std::vector<std::vector<Poly>>& keys) {
+    Poly mu = ct.c;
+    for (unsigned int party : ct.parties) {
+        mu = mu * keys.at(party).at(ct.level);
+    }
+    mu.SwitchFormat();
+    const uint64_t modulus = mu.GetModulus().ConvertToInt();
+    uint64_t max_abs = 0;
+    for (size_t i = 0; i < mu.GetLength(); ++i) {
+        uint64_t value = mu[i].ConvertToInt();
+        max_abs = std::max(max_abs, value > modulus / 2 ? modulus - value : value);
+    }
+    return static_cast<double>(max_abs);
+}
+
+void LogNoise(const std::string& op, const MKCiphertext& ct) {
+    if (!debug_enabled.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(debug_mutex);
+    if (debug_keys.empty()) {
+        return;
+    }
+    const double estimate = std::log2(std::max(NoiseBound(ct), 1.0));
+    const double measured = std::log2(std::max(MeasureNoise(ct, debug_keys), 1.0));
+    std::cerr << "[noise] " << op << " level=" << ct.level << " parties=" << ct.parties.size()
+              << " estimate=2^" << estimate << " measured=2^" << measured
+              << " gap=" << estimate - measured << " bits budget=" << NoiseBudget(ct) << " bits" << std::endl;
+}
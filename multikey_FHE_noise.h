@@ -0,0 +1,44 @@
+#ifndef MULTIKEY_FHE_NOISE_H
+#define MULTIKEY_FHE_NOISE_H
+
+#include "multikey_FHE_relin.h"
+#include <string>
+
+// 雑音の見積もり
+// MKCiphertext::noise は c * F_S (F_S は暗号文が依存するユーザの f の積) の係数の
+// 標準偏差の見積もり。係数の最大値は TAIL 倍までとみなし、それが q/2 を超えると復号を誤る。
+const double TAIL = 6.0;
+
+// 新しい暗号文 c*f = 2gs + 2ef + m*f の雑音
+double FreshNoise(unsigned int degree);
+// ||c * F_S||∞ の見積もり (TAIL * noise)
+double NoiseBound(const MKCiphertext& ct);
+
+double EstimateAddNoise(const MKCiphertext& c1, const MKCiphertext& c2);
+// n 個の暗号文の和 (EvaluateSum) の見積もり
+double EstimateSumNoise(const std::vector<MKCiphertext>& cts);
+// 暗号文を持たずに数だけ分かっている和の見積もり (ストリーミング集計など)
+// 各項は「ユーザ party だけに依存する雑音 noise の暗号文が count 個」
+struct NoiseTerm {
+    unsigned int party;
+    uint64_t count;
+    double noise;
+};
+double EstimateSumNoise(unsigned int degree, const std::vector<NoiseTerm>& terms);
+// 乗算と (共通ユーザについての) 再線形化を合わせた見積もり
+double EstimateMultNoise(const MKCiphertext& c1, const MKCiphertext& c2, unsigned int baseBits);
+double EstimateModSwitchNoise(const MKCiphertext& ct, const NativeInteger& to_modulus);
+
+// 残りの雑音予算 (ビット): log2(q/2) - log2(NoiseBound)。負なら復号できない見込み
+double NoiseBudget(const MKCiphertext& ct);
+// 乗算しても予算が残るか (スケジューラが演算を断る・並べ替える判断に使う)
+bool CanMultiply(const MKCiphertext& c1, const MKCiphertext& c2, unsigned int baseBits);
+
+// デバッグモード
+// keys[i][l] はユーザ i の段 l の秘密鍵。設定すると Evaluate* のたびに実際の雑音を
+// 測って見積もりとの差を std::cerr に出す。空のベクトルで無効になる。
+void SetNoiseDebugKeys(const std::vector<std::vector<Poly>>& keys);
+double MeasureNoise(const MKCiphertext& ct, const std::vector<std::vector<Poly>>& keys);
+void LogNoise(const std::string& op, const MKCiphertext& ct);
+
+#endif
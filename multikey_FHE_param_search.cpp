@@ -0,0 +1,284 @@
+#include "multikey_FHE.h"
+#include "multikey_FHE_relin.h"
+#include "multikey_FHE_party.h"
+#include "multikey_FHE_circuit.h"
+#include "multikey_FHE_sampler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+// 復号失敗率と速度のパラメータ探索
+//   ./param_search [--sigma=0.4,1,3.2] [--degree=8,16,32] [--bits=19,30,40] [--depth=1,2] [--parties=2]
+//                  [--trials=4000] [--target=1e-3] [--confidence=0.95] [--out=search.json]
+// 各組み合わせで「鍵生成 -> 暗号化 -> 深さ depth の積の木 -> 復号」の試行を全コアで繰り返し、
+// 失敗率の Wilson 信頼区間を求める。深さ・ユーザ数は調整するものではなく処理の内容なので、
+// (depth, parties) ごとに、上限が target 未満の (sigma, degree, bits) のうち1試行の評価時間が
+// 最も短いものを best として出力する (結果は JSON)。どれかの (depth, parties) に合格がなければ終了コード 2。
+
+using namespace std;
+
+struct SearchConfig {
+    double sigma;
+    unsigned int degree;
+    unsigned int bits;
+    unsigned int depth;
+    unsigned int parties;
+};
+
+struct SearchResult {
+    SearchConfig config;
+    size_t trials = 0;
+    size_t failures = 0;
+    double lower = 0;
+    double upper = 1;
+    double eval_ns = 0; // 暗号化・評価・復号の1試行あたりの時間 (鍵生成は含まない)
+};
+
+// 両側 confidence の正規分布の分位点 (erf の二分法)
+static double NormalQuantile(double confidence) {
+    const double target = confidence;
+    double lo = 0, hi = 10;
+    for (int i = 0; i < 100; ++i) {
+        const double mid = (lo + hi) / 2;
+        if (std::erf(mid / std::sqrt(2.0)) < target) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo + hi) / 2;
+}
+
+// 二項分布の割合の Wilson スコア区間
+static void WilsonInterval(size_t failures, size_t trials, double z, double& lower, double& upper) {
+    const double n = static_cast<double>(trials);
+    const double p = failures / n;
+    const double z2 = z * z;
+    const double center = (p + z2 / (2 * n)) / (1 + z2 / n);
+    const double half = z * std::sqrt(p * (1 - p) / n + z2 / (4 * n * n)) / (1 + z2 / n);
+    lower = std::max(0.0, center - half);
+    upper = std::min(1.0, center + half);
+}
+
+// 深さ depth の回路: 2^depth 個の入力の積を木で取る (depth = 0 はユーザ数個の入力の和)
+static Circuit BuildCircuit(const SearchConfig& config) {
+    Circuit circuit;
+    const size_t leaves = config.depth == 0 ? config.parties : (size_t(1) << config.depth);
+    std::vector<size_t> level = AddInputs(circuit, leaves);
+    while (level.size() > 1) {
+        std::vector<size_t> next;
+        for (size_t i = 0; i + 1 < level.size(); i += 2) {
+            next.push_back(config.depth == 0 ? Xor(circuit, level[i], level[i + 1]) : And(circuit, level[i], level[i + 1]));
+        }
+        if (level.size() % 2 == 1) {
+            next.push_back(level.back());
+        }
+        level = std::move(next);
+    }
+    circuit.outputs = level;
+    return circuit;
+}
+
+// 1回の試行。復号が正しければ true
+static bool RunTrial(const SearchConfig& config, const Circuit& circuit, std::shared_ptr<ILNativeParams> params,
+                     std::mt19937_64& rng, double& eval_ns) {
+    MultiKeyContext ctx;
+    ctx.degree = config.degree;
+    ctx.params = params;
+    ctx.sk.resize(config.parties);
+    ctx.pk.resize(config.parties);
+    std::vector<EvalKey> evks;
+    for (unsigned int party = 0; party < config.parties; ++party) {
+        while (!KeyGen(config.degree, params, ctx.sk[party], ctx.pk[party]));
+        evks.push_back(EvalKeyGen(ctx.sk[party], ctx.pk[party], config.degree, params));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<MKCiphertext> inputs;
+    int expected = config.depth == 0 ? 0 : 1;
+    for (size_t i = 0; i < circuit.num_inputs; ++i) {
+        const unsigned int party = static_cast<unsigned int>(i % config.parties);
+        const int bit = static_cast<int>(rng() & 1);
+        expected = config.depth == 0 ? expected ^ bit : expected & bit;
+        inputs.push_back(EncryptMK(ctx.pk[party], party, bit, config.degree, params));
+    }
+    const MKCiphertext out = EvaluateCircuit(circuit, inputs, MakeCircuitOps(evks))[0];
+    const int decrypted = Decrypt(CombinedKey(ctx, out.parties), out);
+    eval_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return decrypted == expected;
+}
+
+// 試行を CHUNK 回ずつ並列に行い、区間の下限が target を超えたら (明らかに不合格なので) 打ち切る
+static SearchResult Search(const SearchConfig& config, size_t trials, double target, double z) {
+    const size_t CHUNK = 256;
+    SetSmallPolyDistribution(GAUSSIAN, config.sigma);
+    const unsigned int cyclotomic_order = 2 * config.degree;
+    NativeInteger modulus = lbcrypto::LastPrime<NativeInteger>(config.bits, cyclotomic_order);
+    auto params = std::make_shared<ILNativeParams>(cyclotomic_order, modulus,
+                                                   RootOfUnity<NativeInteger>(cyclotomic_order, modulus));
+    const Circuit circuit = BuildCircuit(config);
+
+    SearchResult result;
+    result.config = config;
+    double total_ns = 0;
+    while (result.trials < trials) {
+        const size_t count = std::min(CHUNK, trials - result.trials);
+        size_t failures = 0;
+        double chunk_ns = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+ : failures, chunk_ns)
+        for (size_t k = 0; k < count; ++k) {
+            std::mt19937_64 rng(result.trials + k);
+            double ns = 0;
+            if (!RunTrial(config, circuit, params, rng, ns)) {
+                ++failures;
+            }
+            chunk_ns += ns;
+        }
+        result.trials += count;
+        result.failures += failures;
+        total_ns += chunk_ns;
+        WilsonInterval(result.failures, result.trials, z, result.lower, result.upper);
+        if (result.lower > target) {
+            break;
+        }
+    }
+    result.eval_ns = total_ns / result.trials;
+    SetSmallPolyDistribution(GAUSSIAN);
+    return result;
+}
+
+template <typename T>
+static std::vector<T> ParseList(const std::string& value) {
+    std::vector<T> list;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        list.push_back(static_cast<T>(std::stod(item)));
+    }
+    return list;
+}
+
+static void WriteResult(std::ostream& out, const SearchResult& r, bool meets) {
+    out << "{\"sigma\": " << r.config.sigma << ", \"degree\": " << r.config.degree
+        << ", \"modulus_bits\": " << r.config.bits << ", \"depth\": " << r.config.depth
+        << ", \"parties\": " << r.config.parties << ", \"trials\": " << r.trials << ", \"failures\": " << r.failures
+        << ", \"failure_rate\": " << static_cast<double>(r.failures) / r.trials << ", \"ci_lower\": " << r.lower
+        << ", \"ci_upper\": " << r.upper << ", \"eval_ns\": " << r.eval_ns
+        << ", \"meets_target\": " << (meets ? "true" : "false") << "}";
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<double> sigmas = {0.4, 1.0, SIGMA};
+    std::vector<unsigned int> degrees = {8, 16, 32};
+    std::vector<unsigned int> bits = {19, 30, 40};
+    std::vector<unsigned int> depths = {1, 2};
+    std::vector<unsigned int> parties = {2};
+    size_t trials = 4000;
+    double target = 1e-3;
+    double confidence = 0.95;
+    std::string out_path;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const size_t eq = arg.find('=');
+        const std::string key = arg.substr(0, eq);
+        const std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--sigma") {
+            sigmas = ParseList<double>(value);
+        } else if (key == "--degree") {
+            degrees = ParseList<unsigned int>(value);
+        } else if (key == "--bits") {
+            bits = ParseList<unsigned int>(value);
+        } else if (key == "--depth") {
+            depths = ParseList<unsigned int>(value);
+        } else if (key == "--parties") {
+            parties = ParseList<unsigned int>(value);
+        } else if (key == "--trials") {
+            trials = std::stoul(value);
+        } else if (key == "--target") {
+            target = std::stod(value);
+        } else if (key == "--confidence") {
+            confidence = std::stod(value);
+        } else if (key == "--out") {
+            out_path = value;
+        } else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--sigma=0.4,3.2] [--degree=8,16] [--bits=19,30] [--depth=1,2] [--parties=2]"
+                         " [--trials=4000] [--target=1e-3] [--confidence=0.95] [--out=file]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    const double z = NormalQuantile(confidence);
+
+    std::vector<SearchResult> results;
+    for (double sigma : sigmas) {
+        for (unsigned int degree : degrees) {
+            for (unsigned int b : bits) {
+                for (unsigned int depth : depths) {
+                    for (unsigned int p : parties) {
+                        SearchConfig config{sigma, degree, b, depth, std::max(p, 1u)};
+                        SearchResult r = Search(config, std::max<size_t>(trials, 1), target, z);
+                        std::cerr << "sigma=" << sigma << " degree=" << degree << " bits=" << b << " depth=" << depth
+                                  << " parties=" << p << ": " << r.failures << "/" << r.trials << " failures, CI ["
+                                  << r.lower << ", " << r.upper << "], " << r.eval_ns << " ns/trial" << std::endl;
+                        results.push_back(r);
+                    }
+                }
+            }
+        }
+    }
+
+    // (depth, parties) ごとに、信頼区間の上限が target 未満のもののうち最速
+    struct Workload {
+        unsigned int depth;
+        unsigned int parties;
+        const SearchResult* best;
+    };
+    std::vector<Workload> workloads;
+    for (const SearchResult& r : results) {
+        auto it = std::find_if(workloads.begin(), workloads.end(), [&r](const Workload& w) {
+            return w.depth == r.config.depth && w.parties == r.config.parties;
+        });
+        if (it == workloads.end()) {
+            workloads.push_back({r.config.depth, r.config.parties, nullptr});
+            it = workloads.end() - 1;
+        }
+        if (r.upper < target && (it->best == nullptr || r.eval_ns < it->best->eval_ns)) {
+            it->best = &r;
+        }
+    }
+    const bool all_pass = std::all_of(workloads.begin(), workloads.end(), [](const Workload& w) { return w.best != nullptr; });
+
+    std::ofstream file;
+    if (!out_path.empty()) {
+        file.open(out_path);
+    }
+    std::ostream& out = out_path.empty() ? std::cout : file;
+    out << "{\n  \"target_failure_rate\": " << target << ", \"confidence\": " << confidence
+        << ", \"threads\": " << omp_get_max_threads() << ",\n  \"results\": [";
+    for (size_t k = 0; k < results.size(); ++k) {
+        out << (k == 0 ? "\n    " : ",\n    ");
+        WriteResult(out, results[k], results[k].upper < target);
+    }
+    out << "\n  ],\n  \"best\": [";
+    for (size_t k = 0; k < workloads.size(); ++k) {
+        out << (k == 0 ? "\n    " : ",\n    ") << "{\"depth\": " << workloads[k].depth
+            << ", \"parties\": " << workloads[k].parties << ", \"config\": ";
+        if (workloads[k].best != nullptr) {
+            WriteResult(out, *workloads[k].best, true);
+        } else {
+            out << "null";
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+    return all_pass ? 0 : 2;
+}
@@ -0,0 +1,68 @@
+#include "multikey_FHE_party.h"
+#include <stdexcept>
+
+using namespace std;
+
+MultiKeyContext GenerateMultiKeyContext(unsigned int parties, unsigned int degree, std::shared_ptr<ILNativeParams> params) {
+    MultiKeyContext ctx;
+    ctx.degree = degree;
+    ctx.params = params;
+    ctx.sk.resize(parties);
+    ctx.pk.resize(parties);
+
+#pragma omp parallel for schedule(dynamic)
+    for (unsigned int party = 0; party < parties; ++party) {
+        while (!KeyGen(degree, params, ctx.sk[party], ctx.pk[party]));
+    }
+    return ctx;
+}
+
+Poly CombineKeys(std::vector<Poly> keys) {
+    if (keys.empty()) {
+        throw std::invalid_argument("CombineKeys: no keys");
+    }
+    // keys[i] *= keys[i + stride] を stride = 1, 2, 4, ... の順に行う
+    for (size_t stride = 1; stride < keys.size(); stride *= 2) {
+        const size_t pairs = (keys.size() + 2 * stride - 1) / (2 * stride);
+#pragma omp parallel for schedule(static)
+        for (size_t p = 0; p < pairs; ++p) {
+            const size_t i = 2 * stride * p;
+            if (i + stride < keys.size()) {
+                keys[i] = keys[i] * keys[i + stride];
+            }
+        }
+    }
+    return keys[0];
+}
+
+Poly CombinedKey(const MultiKeyContext& ctx, const std::vector<unsigned int>& parties) {
+    std::vector<Poly> keys;
+    keys.reserve(parties.size());
+    for (unsigned int party : parties) {
+        keys.push_back(ctx.sk.at(party));
+    }
+    return CombineKeys(std::move(keys));
+}
+
+// 2e_i は d_i を鍵の積だけからずらすための通常の雑音で、f_i を隠す smudging ではない (multikey_FHE_party.h の注意を参照)
+Poly PartialDecrypt(const Poly& share, const Poly& sk, unsigned int degree, std::shared_ptr<ILNativeParams> params) {
+    Poly e = GenerateSmallPoly(degree, params);
+    e.SwitchFormat();
+    return share * sk + e * 2;
+}
+
+int FinalizeDecrypt(const Poly& share, const Poly& sk) {
+    return Decrypt(sk, share);
+}
+
+int DistributedDecrypt(const MultiKeyContext& ctx, const MKCiphertext& ct) {
+    if (ct.parties.empty()) {
+        throw std::invalid_argument("DistributedDecrypt: ciphertext has no parties");
+    }
+    // 各ユーザの手元で行う処理を順に呼ぶ (d_i は次のユーザに渡すだけの値)
+    Poly share = ct.c;
+    for (size_t i = 0; i + 1 < ct.parties.size(); ++i) {
+        share = PartialDecrypt(share, ctx.sk.at(ct.parties[i]), ctx.degree, ctx.params);
+    }
+    return FinalizeDecrypt(share, ctx.sk.at(ct.parties.back()));
+}
@@ -0,0 +1,34 @@
+#ifndef MULTIKEY_FHE_PARTY_H
+#define MULTIKEY_FHE_PARTY_H
+
+#include "multikey_FHE_relin.h"
+
+// k ユーザの鍵をまとめて持つ
+// sk[i], pk[i] はユーザ i の鍵 (評価形式)。MKCiphertext::parties の番号はこの添字。
+struct MultiKeyContext {
+    unsigned int degree = 0;
+    std::shared_ptr<ILNativeParams> params;
+    std::vector<Poly> sk;
+    std::vector<Poly> pk;
+};
+
+// 全ユーザの鍵を OpenMP で並列に生成する (逆元がなければそのユーザだけ再試行)
+MultiKeyContext GenerateMultiKeyContext(unsigned int parties, unsigned int degree, std::shared_ptr<ILNativeParams> params);
+
+// 鍵の積を2つずつの木で求める (段数 ceil(log2 k)、各段の積は並列)
+Poly CombineKeys(std::vector<Poly> keys);
+// parties に含まれるユーザの合成鍵 F_S
+Poly CombinedKey(const MultiKeyContext& ctx, const std::vector<unsigned int>& parties);
+
+// 分散復号
+// 合成鍵を一か所で作らずに、各ユーザが自分の f_i だけを使って順に掛ける:
+//   d_0 = c,  d_i = d_{i-1} * f_i + 2e_i  (e_i は通常の小さい分布 (SIGMA) の雑音、パリティは変えない)
+// 最後のユーザは d を作らず FinalizeDecrypt で定数項のパリティだけを取る。
+// 注意: e_i は d_{i-1} * f_i に含まれる雑音 (f_i に依存する) を統計的に隠せる大きさではない
+// (smudging の雑音は入れていない)。d_i からは f_i についての情報が漏れうるので、d_i は信頼できる
+// 次のユーザにだけ渡すこととし、公開してはならない。
+Poly PartialDecrypt(const Poly& share, const Poly& sk, unsigned int degree, std::shared_ptr<ILNativeParams> params);
+int FinalizeDecrypt(const Poly& share, const Poly& sk);
+int DistributedDecrypt(const MultiKeyContext& ctx, const MKCiphertext& ct);
+
+#endif
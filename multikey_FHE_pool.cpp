@@ -0,0 +1,38 @@
+#include "multikey_FHE_pool.h"
+#include <map>
+
+using namespace std;
+
+static std::map<const ILNativeParams*, std::vector<Poly>>& ThreadPool() {
+    thread_local std::map<const ILNativeParams*, std::vector<Poly>> pool;
+    return pool;
+}
+
+Poly AcquirePoly(std::shared_ptr<ILNativeParams> params, Format format) {
+    std::vector<Poly>& free_list = ThreadPool()[params.get()];
+    if (free_list.empty()) {
+        return Poly(params, format, true);
+    }
+    Poly p = std::move(free_list.back());
+    free_list.pop_back();
+    p.OverrideFormat(format);
+    return p;
+}
+
+void ReleasePoly(Poly&& p) {
+    if (p.IsEmpty()) {
+        return;
+    }
+    std::vector<Poly>& free_list = ThreadPool()[p.GetParams().get()];
+    if (free_list.size() < POOL_LIMIT) {
+        free_list.push_back(std::move(p));
+    }
+}
+
+size_t PooledPolyCount() {
+    size_t count = 0;
+    for (const auto& entry : ThreadPool()) {
+        count += entry.second.size();
+    }
+    return count;
+}
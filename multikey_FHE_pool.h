@@ -0,0 +1,27 @@
+#ifndef MULTIKEY_FHE_POOL_H
+#define MULTIKEY_FHE_POOL_H
+
+#include "multikey_FHE.h"
+
+// 多項式バッファのスレッドごとのプール
+// 使い終わった Poly を環のパラメータ (ILNativeParams) ごとに取っておき、次の AcquirePoly で
+// 係数ベクトルを確保し直さずに再利用する。定常状態では演算ごとのヒープ確保がなくなる。
+// プール中の Poly は params の shared_ptr を持っているので、キーのポインタは無効にならない。
+const size_t POOL_LIMIT = 64; // パラメータごとに取っておく最大数
+
+// 係数の中身は不定 (format は指定どおりに付け替えるだけで変換はしない)
+Poly AcquirePoly(std::shared_ptr<ILNativeParams> params, Format format);
+void ReleasePoly(Poly&& p);
+// このスレッドのプールにある Poly の数
+size_t PooledPolyCount();
+
+// スコープを抜けるとプールに返す作業用の多項式
+struct PooledPoly {
+    Poly poly;
+    PooledPoly(std::shared_ptr<ILNativeParams> params, Format format) : poly(AcquirePoly(std::move(params), format)) {}
+    ~PooledPoly() { ReleasePoly(std::move(poly)); }
+    PooledPoly(const PooledPoly&) = delete;
+    PooledPoly& operator=(const PooledPoly&) = delete;
+};
+
+#endif
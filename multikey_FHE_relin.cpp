@@ -0,0 +1,90 @@
+#include "multikey_FHE_relin.h"
+#include "multikey_FHE_noise.h"
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+
+// 評価鍵生成: 2^{τw} f を公開鍵 h で暗号化したもの
+EvalKey EvalKeyGen(const Poly& sk, const Poly& pk, unsigned int degree, std::shared_ptr<ILNativeParams> params, unsigned int baseBits) {
+    EvalKey evk;
+    evk.baseBits = baseBits;
+    std::vector<Poly> powers = sk.PowersOfBase(baseBits);
+    evk.digits.reserve(powers.size());
+    for (const Poly& power : powers) {
+        Poly s = GenerateSmallPoly(degree, params);
+        Poly e = GenerateSmallPoly(degree, params);
+        s.SwitchFormat();
+        e.SwitchFormat();
+        evk.digits.push_back(pk * s + e * 2 + power);
+    }
+    return evk;
+}
+
+// 再線形化: c を baseBits ずつの桁に分解して評価鍵と内積を取る
+Poly Relinearize(const Poly& c, const EvalKey& evk) {
+    std::vector<Poly> digits = c.BaseDecompose(evk.baseBits, true);
+    Poly& result = digits[0];
+    MultInPlace(result, evk.digits[0]);
+    for (size_t i = 1; i < digits.size(); ++i) {
+        MulAddInPlace(result, digits[i], evk.digits[i]);
+    }
+    return std::move(result);
+}
+
+MKCiphertext EncryptMK(const Poly& pk, unsigned int party, int message, unsigned int degree, std::shared_ptr<ILNativeParams> params) {
+    MKCiphertext ct;
+    ct.c = Encrypt(pk, message, degree, params);
+    ct.parties = {party};
+    ct.noise = FreshNoise(degree);
+    return ct;
+}
+
+// 定数 m の評価形式は全スロットが m
+MKCiphertext EncryptConstant(int message, std::shared_ptr<ILNativeParams> params) {
+    MKCiphertext ct;
+    ct.c = Poly(params, EVALUATION, true);
+    if ((message & 1) != 0) {
+        ct.c += NativeInteger(1);
+    }
+    ct.noise = 1.0; // c * F_S = m * F_S なので雑音は m (<= 1) とみなす
+    return ct;
+}
+
+// 同型加算: 依存するユーザは和集合になる (鍵の次数は増えない)
+MKCiphertext EvaluateAdd(const MKCiphertext& c1, const MKCiphertext& c2) {
+    MKCiphertext result;
+    result.c = EvaluateAdd(c1.c, c2.c);
+    result.level = c1.level;
+    result.noise = EstimateAddNoise(c1, c2);
+    std::set_union(c1.parties.begin(), c1.parties.end(), c2.parties.begin(), c2.parties.end(),
+                   std::back_inserter(result.parties));
+    LogNoise("add", result);
+    return result;
+}
+
+// 同型乗算 + 再線形化
+MKCiphertext EvaluateMult(const MKCiphertext& c1, const MKCiphertext& c2, const std::vector<EvalKey>& evks) {
+    MKCiphertext result;
+    result.c = EvaluateMult(c1.c, c2.c);
+    result.level = c1.level;
+
+    // 両方に現れるユーザは鍵の次数が 2 になっているので 1 に戻す
+    std::vector<unsigned int> shared;
+    std::set_intersection(c1.parties.begin(), c1.parties.end(), c2.parties.begin(), c2.parties.end(),
+                          std::back_inserter(shared));
+    for (unsigned int party : shared) {
+        result.c = Relinearize(result.c, evks.at(party));
+    }
+
+    std::set_union(c1.parties.begin(), c1.parties.end(), c2.parties.begin(), c2.parties.end(),
+                   std::back_inserter(result.parties));
+    result.noise = EstimateMultNoise(c1, c2, shared.empty() ? 0 : evks.at(shared[0]).baseBits);
+    LogNoise("mult", result);
+    return result;
+}
+
+// 合成鍵に含まれるが暗号文が依存しないユーザの f は ≡ 1 (mod 2) なので結果に影響しない
+int Decrypt(const Poly& sk_combined, const MKCiphertext& ct) {
+    return Decrypt(sk_combined, ct.c);
+}
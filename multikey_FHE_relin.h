@@ -0,0 +1,38 @@
+#ifndef MULTIKEY_FHE_RELIN_H
+#define MULTIKEY_FHE_RELIN_H
+
+#include "multikey_FHE.h"
+
+// 再線形化 (鍵スイッチング)
+// 暗号文の積は各ユーザ鍵の次数を足し合わせるので、同じユーザの暗号文同士を掛けると
+// 復号に f_i^2 が必要になる。評価鍵
+//   evk_i[τ] = h_i * s_τ + 2 e_τ + 2^{τw} f_i
+// を使って c を w ビットずつ分解した D_τ(c) と掛けて足すと
+//   (Σ D_τ(c) evk_i[τ]) * f_i ≡ c * f_i^2  (mod 2 の雑音を除いて)
+// となり、f_i の次数を 2 から 1 に戻せる。
+struct EvalKey {
+    unsigned int baseBits;
+    std::vector<Poly> digits;
+};
+
+EvalKey EvalKeyGen(const Poly& sk, const Poly& pk, unsigned int degree, std::shared_ptr<ILNativeParams> params, unsigned int baseBits = 4);
+Poly Relinearize(const Poly& c, const EvalKey& evk);
+
+// どのユーザの鍵に依存しているかを持つ暗号文
+// 各ユーザの鍵の次数は常に 1 に保たれるので、全ユーザの f の積 (固定の合成鍵) で復号できる
+struct MKCiphertext {
+    Poly c;
+    std::vector<unsigned int> parties; // 昇順・重複なし
+    unsigned int level = 0;            // 法の段 (multikey_FHE_modswitch.h の ModulusChain の添字)
+    double noise = 0;                  // 雑音 c * F_S の係数の標準偏差の見積もり (multikey_FHE_noise.h)
+};
+
+MKCiphertext EncryptMK(const Poly& pk, unsigned int party, int message, unsigned int degree, std::shared_ptr<ILNativeParams> params);
+// 自明な暗号文 c = m (どのユーザにも依存しない定数。回路の定数ノードに使う)
+MKCiphertext EncryptConstant(int message, std::shared_ptr<ILNativeParams> params);
+MKCiphertext EvaluateAdd(const MKCiphertext& c1, const MKCiphertext& c2);
+// evks[i] はユーザ i の評価鍵。両方の暗号文に現れるユーザについて再線形化する
+MKCiphertext EvaluateMult(const MKCiphertext& c1, const MKCiphertext& c2, const std::vector<EvalKey>& evks);
+int Decrypt(const Poly& sk_combined, const MKCiphertext& ct);
+
+#endif
@@ -0,0 +1,120 @@
+#include "multikey_FHE_sampler.h"
+#include <map>
+#include <random>
+
+using namespace std;
+
+static SmallDistribution small_distribution = GAUSSIAN;
+static double small_sigma = SIGMA;
+
+DiscreteGaussianGeneratorImpl<NativeVector>& GetGaussianSampler(double sigma) {
+    thread_local std::map<double, std::unique_ptr<DiscreteGaussianGeneratorImpl<NativeVector>>> samplers;
+    auto& sampler = samplers[sigma];
+    if (!sampler) {
+        sampler = std::make_unique<DiscreteGaussianGeneratorImpl<NativeVector>>(sigma);
+    }
+    return *sampler;
+}
+
+TernaryUniformGeneratorImpl<NativeVector>& GetTernarySampler() {
+    thread_local TernaryUniformGeneratorImpl<NativeVector> sampler;
+    return sampler;
+}
+
+BinaryUniformGeneratorImpl<NativeVector>& GetBinarySampler() {
+    thread_local BinaryUniformGeneratorImpl<NativeVector> sampler;
+    return sampler;
+}
+
+void SetSmallPolyDistribution(SmallDistribution distribution, double sigma) {
+    small_distribution = distribution;
+    small_sigma = sigma;
+}
+
+SmallDistribution GetSmallPolyDistribution() {
+    return small_distribution;
+}
+
+double GetSmallPolySigma() {
+    return small_sigma;
+}
+
+double SmallPolyVariance() {
+    switch (small_distribution) {
+        case TERNARY:
+            return 2.0 / 3.0;
+        case BINARY:
+            return 0.5;
+        default:
+            return small_sigma * small_sigma;
+    }
+}
+
+Poly GenerateSmallPoly(SmallDistribution distribution, double sigma, std::shared_ptr<ILNativeParams> params) {
+    switch (distribution) {
+        case TERNARY:
+            return Poly(GetTernarySampler(), params, COEFFICIENT);
+        case BINARY:
+            return Poly(GetBinarySampler(), params, COEFFICIENT);
+        default:
+            return Poly(GetGaussianSampler(sigma), params, COEFFICIENT);
+    }
+}
+
+std::vector<Poly> GenerateSmallPolys(size_t count, std::shared_ptr<ILNativeParams> params) {
+    const usint n = params->GetRingDimension();
+    const NativeInteger& modulus = params->GetModulus();
+
+    // count * N 個の係数を一度に引いてから各多項式に分ける
+    NativeVector samples;
+    switch (small_distribution) {
+        case TERNARY:
+            samples = GetTernarySampler().GenerateVector(count * n, modulus);
+            break;
+        case BINARY:
+            samples = GetBinarySampler().GenerateVector(count * n, modulus);
+            break;
+        default:
+            samples = GetGaussianSampler(small_sigma).GenerateVector(count * n, modulus);
+            break;
+    }
+
+    std::vector<Poly> polys;
+    polys.reserve(count);
+    for (size_t k = 0; k < count; ++k) {
+        Poly p(params, COEFFICIENT, true);
+        for (usint i = 0; i < n; ++i) {
+            p[i] = samples[k * n + i];
+        }
+        polys.push_back(std::move(p));
+    }
+    return polys;
+}
+
+void SampleSmallPoly(Poly& p) {
+    const NativeInteger& modulus = p.GetModulus();
+    const uint64_t q = modulus.ConvertToInt();
+    const usint n = p.GetLength();
+    p.OverrideFormat(COEFFICIENT);
+    switch (small_distribution) {
+        case TERNARY:
+        case BINARY: {
+            auto& prng = lbcrypto::PseudoRandomNumberGenerator::GetPRNG();
+            std::uniform_int_distribution<int> dist(small_distribution == TERNARY ? -1 : 0, 1);
+            for (usint i = 0; i < n; ++i) {
+                int x = dist(prng);
+                p[i] = x < 0 ? NativeInteger(q - 1) : NativeInteger(static_cast<uint64_t>(x));
+            }
+            break;
+        }
+        default: {
+            const auto& sampler = GetGaussianSampler(small_sigma);
+            for (usint i = 0; i < n; ++i) {
+                int32_t x = sampler.GenerateInt();
+                p[i] = x < 0 ? NativeInteger(q - static_cast<uint64_t>(-static_cast<int64_t>(x)))
+                             : NativeInteger(static_cast<uint64_t>(x));
+            }
+            break;
+        }
+    }
+}
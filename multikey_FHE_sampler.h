@@ -0,0 +1,36 @@
+#ifndef MULTIKEY_FHE_SAMPLER_H
+#define MULTIKEY_FHE_SAMPLER_H
+
+#include "multikey_FHE.h"
+
+using lbcrypto::TernaryUniformGeneratorImpl;
+using lbcrypto::BinaryUniformGeneratorImpl;
+
+// 小さい多項式 (鍵・雑音) の分布
+enum SmallDistribution {
+    GAUSSIAN, // 離散ガウス分布 (標準偏差 sigma)
+    TERNARY,  // {-1, 0, 1} の一様分布
+    BINARY    // {0, 1} の一様分布
+};
+
+// サンプラはスレッドごと・sigma ごとに1つだけ作って使い回す。
+// DiscreteGaussianGeneratorImpl の生成は表の構築と乱数の初期化を伴うので毎回作ると遅い。
+DiscreteGaussianGeneratorImpl<NativeVector>& GetGaussianSampler(double sigma);
+TernaryUniformGeneratorImpl<NativeVector>& GetTernarySampler();
+BinaryUniformGeneratorImpl<NativeVector>& GetBinarySampler();
+
+// GenerateSmallPoly が使う分布 (既定は GAUSSIAN, SIGMA)
+// 全スレッドで共有されるので、並列処理の外で設定すること
+void SetSmallPolyDistribution(SmallDistribution distribution, double sigma = SIGMA);
+SmallDistribution GetSmallPolyDistribution();
+double GetSmallPolySigma();
+// 設定中の分布の係数の二乗平均 (雑音の見積もりに使う)
+double SmallPolyVariance();
+
+Poly GenerateSmallPoly(SmallDistribution distribution, double sigma, std::shared_ptr<ILNativeParams> params);
+// count 個の小さい多項式を1回のサンプラ呼び出しでまとめて生成する (係数形式)
+std::vector<Poly> GenerateSmallPolys(size_t count, std::shared_ptr<ILNativeParams> params);
+// 確保済みの p に係数を1つずつ引いて書き込む (係数形式になる。新しいベクトルを作らない)
+void SampleSmallPoly(Poly& p);
+
+#endif
@@ -0,0 +1,370 @@
+#include "multikey_FHE_serial.h"
+#include "multikey_FHE_simd.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char POLY_MAGIC[4] = {'M', 'K', 'P', 'L'};
+
+template <typename T>
+static void WriteValue(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static T ReadValue(std::istream& in) {
+    T value{};
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    if (!in) {
+        throw std::runtime_error("ReadPoly: unexpected end of stream");
+    }
+    return value;
+}
+
+unsigned int CoefficientBits(uint64_t modulus) {
+    unsigned int bits = 0;
+    for (uint64_t x = modulus - 1; x != 0; x >>= 1) {
+        ++bits;
+    }
+    return bits == 0 ? 1 : bits;
+}
+
+size_t PackedBytes(size_t n, unsigned int bits) {
+    return (n * bits + 7) / 8;
+}
+
+void PackCoefficients(const uint64_t* values, size_t n, unsigned int bits, uint8_t* out) {
+    unsigned __int128 buffer = 0;
+    unsigned int filled = 0;
+    for (size_t i = 0; i < n; ++i) {
+        buffer |= static_cast<unsigned __int128>(values[i]) << filled;
+        filled += bits;
+        while (filled >= 8) {
+            *out++ = static_cast<uint8_t>(buffer);
+            buffer >>= 8;
+            filled -= 8;
+        }
+    }
+    if (filled > 0) {
+        *out = static_cast<uint8_t>(buffer);
+    }
+}
+
+void UnpackCoefficients(const uint8_t* in, size_t n, unsigned int bits, uint64_t* values) {
+    const uint64_t mask = bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+    unsigned __int128 buffer = 0;
+    unsigned int filled = 0;
+    for (size_t i = 0; i < n; ++i) {
+        while (filled < bits) {
+            buffer |= static_cast<unsigned __int128>(*in++) << filled;
+            filled += 8;
+        }
+        values[i] = static_cast<uint64_t>(buffer) & mask;
+        buffer >>= bits;
+        filled -= bits;
+    }
+}
+
+void WritePoly(std::ostream& out, const Poly& p) {
+    const uint32_t n = p.GetLength();
+    const uint64_t q = p.GetModulus().ConvertToInt();
+    const uint8_t format = p.GetFormat() == EVALUATION ? 0 : 1;
+    const uint8_t bits = static_cast<uint8_t>(CoefficientBits(q));
+    out.write(POLY_MAGIC, sizeof(POLY_MAGIC));
+    WriteValue(out, n);
+    WriteValue(out, q);
+    WriteValue(out, format);
+    WriteValue(out, bits);
+    std::vector<uint8_t> packed(PackedBytes(n, bits));
+    PackCoefficients(SlotData(p), n, bits, packed.data());
+    out.write(reinterpret_cast<const char*>(packed.data()), packed.size());
+    if (!out) {
+        throw std::runtime_error("WritePoly: write failed");
+    }
+}
+
+Poly ReadPoly(std::istream& in, std::shared_ptr<ILNativeParams> params) {
+    char magic[sizeof(POLY_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, POLY_MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error("ReadPoly: not a serialized polynomial");
+    }
+    const uint32_t n = ReadValue<uint32_t>(in);
+    const uint64_t q = ReadValue<uint64_t>(in);
+    const uint8_t format = ReadValue<uint8_t>(in);
+    const uint8_t bits = ReadValue<uint8_t>(in);
+    if (n != params->GetRingDimension() || q != params->GetModulus().ConvertToInt() || bits != CoefficientBits(q) || format > 1) {
+        throw std::runtime_error("ReadPoly: header does not match params");
+    }
+    std::vector<uint8_t> packed(PackedBytes(n, bits));
+    in.read(reinterpret_cast<char*>(packed.data()), packed.size());
+    if (!in) {
+        throw std::runtime_error("ReadPoly: unexpected end of stream");
+    }
+    Poly p(params, format == 0 ? EVALUATION : COEFFICIENT, true);
+    UnpackCoefficients(packed.data(), n, bits, SlotData(p));
+    for (uint32_t i = 0; i < n; ++i) {
+        if (SlotData(p)[i] >= q) {
+            throw std::runtime_error("ReadPoly: coefficient out of range");
+        }
+    }
+    return p;
+}
+
+void WriteCiphertext(std::ostream& out, const MKCiphertext& ct) {
+    WritePoly(out, ct.c);
+    WriteValue(out, static_cast<uint32_t>(ct.level));
+    WriteValue(out, ct.noise);
+    WriteValue(out, static_cast<uint32_t>(ct.parties.size()));
+    for (unsigned int party : ct.parties) {
+        WriteValue(out, static_cast<uint32_t>(party));
+    }
+}
+
+MKCiphertext ReadCiphertext(std::istream& in, std::shared_ptr<ILNativeParams> params) {
+    MKCiphertext ct;
+    ct.c = ReadPoly(in, params);
+    ct.level = ReadValue<uint32_t>(in);
+    ct.noise = ReadValue<double>(in);
+    const uint32_t parties = ReadValue<uint32_t>(in);
+    for (uint32_t i = 0; i < parties; ++i) {
+        ct.parties.push_back(ReadValue<uint32_t>(in));
+    }
+    return ct;
+}
+
+// ---- CiphertextStore ----
+// ファイルの先頭 32 バイト: "MKSTORE1", N (uint32), ビット幅 (uint8) + 予約 3 バイト, q (uint64), 件数 (uint64)
+// 以降に固定長のレコードが並ぶ。ファイルは確保済みの領域ごとマップし、閉じるときに実際の長さに切り詰める。
+
+static const char STORE_MAGIC[8] = {'M', 'K', 'S', 'T', 'O', 'R', 'E', '1'};
+static const size_t STORE_HEADER_BYTES = 32;
+static const size_t STORE_MIN_MAP = 1 << 20;
+
+static std::runtime_error StoreError(const std::string& what) {
+    return std::runtime_error("CiphertextStore: " + what + ": " + std::strerror(errno));
+}
+
+static uint64_t& StoreCount(uint8_t* map) {
+    return *reinterpret_cast<uint64_t*>(map + 24);
+}
+
+CiphertextStore::CiphertextStore(const std::string& path, std::shared_ptr<ILNativeParams> params)
+    : m_params(std::move(params)) {
+    const uint32_t n = m_params->GetRingDimension();
+    const uint64_t q = m_params->GetModulus().ConvertToInt();
+    m_bits = CoefficientBits(q);
+    m_record_bytes = 1 + PackedBytes(n, m_bits);
+
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0) {
+        throw StoreError("cannot open " + path);
+    }
+    struct stat st;
+    if (::fstat(m_fd, &st) != 0) {
+        ::close(m_fd);
+        throw StoreError("cannot stat " + path);
+    }
+
+    if (st.st_size == 0) {
+        try {
+            Reserve(STORE_HEADER_BYTES);
+        } catch (...) {
+            ::close(m_fd);
+            throw;
+        }
+        std::memcpy(m_map, STORE_MAGIC, sizeof(STORE_MAGIC));
+        std::memcpy(m_map + 8, &n, sizeof(n));
+        m_map[12] = static_cast<uint8_t>(m_bits);
+        std::memcpy(m_map + 16, &q, sizeof(q));
+        StoreCount(m_map) = 0;
+        return;
+    }
+
+    // ヘッダを読む前に大きさを確かめる (短いファイルのマップの外を読まない)
+    if (static_cast<uint64_t>(st.st_size) < STORE_HEADER_BYTES) {
+        ::close(m_fd);
+        throw std::runtime_error("CiphertextStore: " + path + " is too short to be a store");
+    }
+    m_map = static_cast<uint8_t*>(::mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0));
+    if (m_map == MAP_FAILED) {
+        m_map = nullptr;
+        ::close(m_fd);
+        throw StoreError("cannot map " + path);
+    }
+    m_mapped = st.st_size;
+    uint32_t file_n = 0;
+    uint64_t file_q = 0;
+    std::memcpy(&file_n, m_map + 8, sizeof(file_n));
+    std::memcpy(&file_q, m_map + 16, sizeof(file_q));
+    // 件数は掛け算せずに割り算で確かめる (壊れた件数で桁あふれして検査を通り抜けないように)
+    if (std::memcmp(m_map, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0 || file_n != n || file_q != q ||
+        m_map[12] != m_bits || StoreCount(m_map) > (m_mapped - STORE_HEADER_BYTES) / m_record_bytes) {
+        ::munmap(m_map, m_mapped);
+        ::close(m_fd);
+        throw std::runtime_error("CiphertextStore: " + path + " is not a store for these params");
+    }
+}
+
+CiphertextStore::~CiphertextStore() {
+    if (m_map != nullptr) {
+        const size_t used = STORE_HEADER_BYTES + StoreCount(m_map) * m_record_bytes;
+        ::munmap(m_map, m_mapped);
+        if (::ftruncate(m_fd, used) != 0) {
+            // 切り詰めに失敗しても件数はヘッダにあるので、余りは読み捨てられる
+        }
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+// 少なくとも bytes バイトをマップする (倍々に伸ばす)
+void CiphertextStore::Reserve(size_t bytes) {
+    if (bytes <= m_mapped) {
+        return;
+    }
+    const size_t size = std::max({bytes, 2 * m_mapped, STORE_MIN_MAP});
+    // 伸ばしたファイルを新しくマップできてから古いマップを外す
+    // (失敗しても古いマップと件数はそのままなので、ストアは使い続けられる。伸びた分はデストラクタで切り詰める)
+    if (::ftruncate(m_fd, size) != 0) {
+        throw StoreError("cannot grow file");
+    }
+    void* map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (map == MAP_FAILED) {
+        throw StoreError("cannot map file");
+    }
+    if (m_map != nullptr) {
+        ::munmap(m_map, m_mapped);
+    }
+    m_map = static_cast<uint8_t*>(map);
+    m_mapped = size;
+}
+
+size_t CiphertextStore::Append(const Poly& c) {
+    if (c.GetLength() != m_params->GetRingDimension() || c.GetModulus() != m_params->GetModulus()) {
+        throw std::invalid_argument("CiphertextStore::Append: ciphertext does not match the store params");
+    }
+    const size_t index = StoreCount(m_map);
+    const size_t offset = STORE_HEADER_BYTES + index * m_record_bytes;
+    Reserve(offset + m_record_bytes);
+    uint8_t* record = m_map + offset;
+    record[0] = c.GetFormat() == EVALUATION ? 0 : 1;
+    PackCoefficients(SlotData(c), c.GetLength(), m_bits, record + 1);
+    StoreCount(m_map) = index + 1;
+    return index;
+}
+
+size_t CiphertextStore::Size() const {
+    return StoreCount(m_map);
+}
+
+// 形式のバイトが 0/1 以外のレコードは壊れているとみなす
+const uint8_t* CiphertextStore::RecordData(size_t index, Format& format) const {
+    if (index >= Size()) {
+        throw std::out_of_range("CiphertextStore: index out of range");
+    }
+    const uint8_t* record = m_map + STORE_HEADER_BYTES + index * m_record_bytes;
+    if (record[0] > 1) {
+        throw std::runtime_error("CiphertextStore: record " + std::to_string(index) + " has an invalid format");
+    }
+    format = record[0] == 0 ? EVALUATION : COEFFICIENT;
+    return record + 1;
+}
+
+// 展開した係数がすべて q 未満か (壊れた・書きかけのレコードは bits ビットの任意の値になりうる)
+static bool CoefficientsInRange(const uint64_t* values, size_t n, uint64_t q) {
+    for (size_t i = 0; i < n; ++i) {
+        if (values[i] >= q) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CiphertextStore::Get(size_t index, Poly& out) const {
+    Format format;
+    const uint8_t* data = RecordData(index, format);
+    if (out.IsEmpty() || out.GetLength() != m_params->GetRingDimension() || out.GetModulus() != m_params->GetModulus()) {
+        out = Poly(m_params, format, true);
+    }
+    out.OverrideFormat(format);
+    UnpackCoefficients(data, out.GetLength(), m_bits, SlotData(out));
+    if (!CoefficientsInRange(SlotData(out), out.GetLength(), m_params->GetModulus().ConvertToInt())) {
+        throw std::runtime_error("CiphertextStore: record " + std::to_string(index) + " has a coefficient out of range");
+    }
+}
+
+Poly CiphertextStore::Get(size_t index) const {
+    Poly out;
+    Get(index, out);
+    return out;
+}
+
+Poly EvaluateSum(const CiphertextStore& store) {
+    const size_t count = store.Size();
+    if (count == 0) {
+        throw std::invalid_argument("EvaluateSum: empty store");
+    }
+    auto params = store.GetParams();
+    const size_t n = params->GetRingDimension();
+    const uint64_t q = params->GetModulus().ConvertToInt();
+    const unsigned int bits = CoefficientBits(q);
+    Format format;
+    store.RecordData(0, format);
+
+    Poly result(params, format, true);
+    uint64_t* out = SlotData(result);
+    bool mixed = false;
+    bool corrupt = false;
+#pragma omp parallel
+    {
+        // q 以上の値を含むレコードは足さないので、1項は q 未満
+        LazyAccumulator acc(n, q);
+        std::vector<uint64_t> values(n);
+#pragma omp for schedule(static) nowait
+        for (size_t k = 0; k < count; ++k) {
+            // 並列領域の外に例外を出せないので、壊れたレコードは印を付けて飛ばし、最後に投げる
+            Format record_format;
+            const uint8_t* data = nullptr;
+            try {
+                data = store.RecordData(k, record_format);
+            } catch (const std::runtime_error&) {
+#pragma omp atomic write
+                corrupt = true;
+                continue;
+            }
+            if (record_format != format) {
+#pragma omp atomic write
+                mixed = true;
+                continue;
+            }
+            UnpackCoefficients(data, n, bits, values.data());
+            if (!CoefficientsInRange(values.data(), n, q)) {
+#pragma omp atomic write
+                corrupt = true;
+                continue;
+            }
+            acc.Add(values.data());
+        }
+        const uint64_t* partial = acc.Reduce();
+#pragma omp critical
+        VecAddMod(out, out, partial, n, q);
+    }
+    if (corrupt) {
+        throw std::runtime_error("EvaluateSum: store has a corrupt record");
+    }
+    if (mixed) {
+        throw std::invalid_argument("EvaluateSum: store mixes coefficient and evaluation records");
+    }
+    return result;
+}
@@ -0,0 +1,64 @@
+#ifndef MULTIKEY_FHE_SERIAL_H
+#define MULTIKEY_FHE_SERIAL_H
+
+#include "multikey_FHE_relin.h"
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+// 直列化
+// 係数は q-1 のビット幅 (q = 320417 なら 19 ビット) で詰めて書く。形式 (評価/係数) も記録するので、
+// 読んだ側は書いたときの形式のまま使え、余計な SwitchFormat がいらない。整数はホストのバイト順。
+//
+// 多項式 1つ: "MKPL", N (uint32), q (uint64), 形式 (uint8: 0 = 評価, 1 = 係数), ビット幅 (uint8), 詰めた係数
+unsigned int CoefficientBits(uint64_t modulus);
+size_t PackedBytes(size_t n, unsigned int bits);
+// values (各 bits ビット未満) を out に詰める / in から n 個取り出す
+void PackCoefficients(const uint64_t* values, size_t n, unsigned int bits, uint8_t* out);
+void UnpackCoefficients(const uint8_t* in, size_t n, unsigned int bits, uint64_t* values);
+
+void WritePoly(std::ostream& out, const Poly& p);
+// params の次数・法がファイルと一致しなければ例外
+Poly ReadPoly(std::istream& in, std::shared_ptr<ILNativeParams> params);
+// MKCiphertext: 多項式のあとに段、雑音の見積もり、ユーザ数とユーザ番号
+void WriteCiphertext(std::ostream& out, const MKCiphertext& ct);
+MKCiphertext ReadCiphertext(std::istream& in, std::shared_ptr<ILNativeParams> params);
+
+// メモリマップした追記専用の暗号文ストア
+// 固定長のレコード (形式 1 バイト + 詰めた係数) を並べるだけなので、i 番目の位置は計算で決まる。
+// ファイルは倍々に伸ばしてマップし直すので、追記ごとのシステムコールはない。
+// 読み出しはマップから直接展開する (read による中間バッファがない)。RAM より大きい集合も扱える。
+// 追記と読み出しを同時に行わないこと (読み出し同士は並列でよい)。
+class CiphertextStore {
+public:
+    // path を開く (なければ作る)。既存のファイルの次数・法は params と一致しなければならない
+    CiphertextStore(const std::string& path, std::shared_ptr<ILNativeParams> params);
+    ~CiphertextStore();
+    CiphertextStore(const CiphertextStore&) = delete;
+    CiphertextStore& operator=(const CiphertextStore&) = delete;
+
+    // 追記して番号を返す
+    size_t Append(const Poly& c);
+    size_t Size() const;
+    std::shared_ptr<ILNativeParams> GetParams() const { return m_params; }
+    // out を確保し直さずに index 番目を書き込む (壊れたレコード (q 以上の係数・不正な形式) は例外)
+    void Get(size_t index, Poly& out) const;
+    Poly Get(size_t index) const;
+    // index 番目のレコードの詰めた係数と形式 (マップの中を直接指す)
+    const uint8_t* RecordData(size_t index, Format& format) const;
+
+private:
+    void Reserve(size_t bytes);
+
+    std::shared_ptr<ILNativeParams> m_params;
+    unsigned int m_bits;
+    size_t m_record_bytes;
+    int m_fd = -1;
+    uint8_t* m_map = nullptr;
+    size_t m_mapped = 0;
+};
+
+// ストアの全暗号文の和 (マップから展開しながら遅延剰余で足す)
+Poly EvaluateSum(const CiphertextStore& store);
+
+#endif
@@ -0,0 +1,293 @@
+#include "multikey_FHE_simd.h"
+#include "multikey_FHE_noise.h"
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MULTIKEY_FHE_X86 1
+#endif
+
+using namespace std;
+
+static_assert(sizeof(NativeInteger) == sizeof(uint64_t), "NativeInteger must be a bare 64-bit word");
+
+// Montgomery 乗算 (R = 2^32) の定数
+struct MontgomeryConstants {
+    uint64_t q_inv_neg; // -q^{-1} mod 2^32
+    uint64_t r2;        // R^2 mod q
+};
+
+static MontgomeryConstants ComputeMontgomery(uint64_t q) {
+    uint32_t inv = static_cast<uint32_t>(q); // q が奇数なら下位 3 ビットは正しい
+    for (int i = 0; i < 4; ++i) {
+        inv *= 2 - static_cast<uint32_t>(q) * inv; // ニュートン法で正しいビット数が倍になる
+    }
+    MontgomeryConstants mc;
+    mc.q_inv_neg = static_cast<uint32_t>(0u - inv);
+    mc.r2 = static_cast<uint64_t>((static_cast<unsigned __int128>(1) << 64) % q);
+    return mc;
+}
+
+// ---- スカラー ----
+
+static void AddModScalar(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q) {
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t s = a[i] + b[i];
+        c[i] = s >= q ? s - q : s;
+    }
+}
+
+static void SubModScalar(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q) {
+    for (size_t i = 0; i < n; ++i) {
+        c[i] = a[i] >= b[i] ? a[i] - b[i] : a[i] + q - b[i];
+    }
+}
+
+static void MulModScalar(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q) {
+    const NativeInteger modulus(q);
+    const NativeInteger mu = modulus.ComputeMu();
+    for (size_t i = 0; i < n; ++i) {
+        c[i] = NativeInteger(a[i]).ModMulFast(NativeInteger(b[i]), modulus, mu).ConvertToInt();
+    }
+}
+
+#ifdef MULTIKEY_FHE_X86
+
+// ---- AVX2 ----
+// 値はすべて 2^63 未満なので、符号なしの比較の代わりに符号付きの _mm256_cmpgt_epi64 を使う
+
+__attribute__((target("avx2"))) static void AddModAVX2(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q) {
+    const __m256i vq = _mm256_set1_epi64x(static_cast<long long>(q));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i s = _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                     _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+        __m256i below = _mm256_cmpgt_epi64(vq, s);
+        s = _mm256_sub_epi64(s, _mm256_andnot_si256(below, vq));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + i), s);
+    }
+    AddModScalar(c + i, a + i, b + i, n - i, q);
+}
+
+__attribute__((target("avx2"))) static void SubModAVX2(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q) {
+    const __m256i vq = _mm256_set1_epi64x(static_cast<long long>(q));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        __m256i borrow = _mm256_cmpgt_epi64(y, x);
+        __m256i d = _mm256_add_epi64(_mm256_sub_epi64(x, y), _mm256_and_si256(borrow, vq));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + i), d);
+    }
+    SubModScalar(c + i, a + i, b + i, n - i, q);
+}
+
+// a * b * 2^{-32} mod q (a, b < q < 2^31)
+__attribute__((target("avx2"))) static inline __m256i MontMulAVX2(__m256i a, __m256i b, __m256i vq, __m256i vq_inv) {
+    __m256i t = _mm256_mul_epu32(a, b);
+    __m256i m = _mm256_mul_epu32(t, vq_inv);
+    __m256i u = _mm256_srli_epi64(_mm256_add_epi64(t, _mm256_mul_epu32(m, vq)), 32);
+    __m256i below = _mm256_cmpgt_epi64(vq, u);
+    return _mm256_sub_epi64(u, _mm256_andnot_si256(below, vq));
+}
+
+__attribute__((target("avx2"))) static void MulModAVX2(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q) {
+    const MontgomeryConstants mc = ComputeMontgomery(q);
+    const __m256i vq = _mm256_set1_epi64x(static_cast<long long>(q));
+    const __m256i vq_inv = _mm256_set1_epi64x(static_cast<long long>(mc.q_inv_neg));
+    const __m256i vr2 = _mm256_set1_epi64x(static_cast<long long>(mc.r2));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        // (ab R^{-1}) * R^2 * R^{-1} = ab
+        __m256i r = MontMulAVX2(MontMulAVX2(x, y, vq, vq_inv), vr2, vq, vq_inv);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + i), r);
+    }
+    MulModScalar(c + i, a + i, b + i, n - i, q);
+}
+
+// ---- AVX-512 ----
+// 条件付きの減算は min(s, s - q) (s < q なら s - q は巡回して大きくなる)
+
+__attribute__((target("avx512f"))) static void AddModAVX512(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q) {
+    const __m512i vq = _mm512_set1_epi64(static_cast<long long>(q));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i s = _mm512_add_epi64(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+        _mm512_storeu_si512(c + i, _mm512_min_epu64(s, _mm512_sub_epi64(s, vq)));
+    }
+    AddModScalar(c + i, a + i, b + i, n - i, q);
+}
+
+__attribute__((target("avx512f"))) static void SubModAVX512(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q) {
+    const __m512i vq = _mm512_set1_epi64(static_cast<long long>(q));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i d = _mm512_sub_epi64(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+        _mm512_storeu_si512(c + i, _mm512_min_epu64(d, _mm512_add_epi64(d, vq)));
+    }
+    SubModScalar(c + i, a + i, b + i, n - i, q);
+}
+
+__attribute__((target("avx512f"))) static inline __m512i MontMulAVX512(__m512i a, __m512i b, __m512i vq, __m512i vq_inv) {
+    __m512i t = _mm512_mul_epu32(a, b);
+    __m512i m = _mm512_mul_epu32(t, vq_inv);
+    __m512i u = _mm512_srli_epi64(_mm512_add_epi64(t, _mm512_mul_epu32(m, vq)), 32);
+    return _mm512_min_epu64(u, _mm512_sub_epi64(u, vq));
+}
+
+__attribute__((target("avx512f"))) static void MulModAVX512(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q) {
+    const MontgomeryConstants mc = ComputeMontgomery(q);
+    const __m512i vq = _mm512_set1_epi64(static_cast<long long>(q));
+    const __m512i vq_inv = _mm512_set1_epi64(static_cast<long long>(mc.q_inv_neg));
+    const __m512i vr2 = _mm512_set1_epi64(static_cast<long long>(mc.r2));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i r = MontMulAVX512(MontMulAVX512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i), vq, vq_inv),
+                                  vr2, vq, vq_inv);
+        _mm512_storeu_si512(c + i, r);
+    }
+    MulModScalar(c + i, a + i, b + i, n - i, q);
+}
+
+#endif
+
+// ---- 実行時の選択 ----
+
+static SimdLevel DetectSimdLevel() {
+#ifdef MULTIKEY_FHE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SIMD_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMD_AVX2;
+    }
+#endif
+    return SIMD_SCALAR;
+}
+
+static SimdLevel& CurrentSimdLevel() {
+    static SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+SimdLevel GetSimdLevel() {
+    return CurrentSimdLevel();
+}
+
+void SetSimdLevel(SimdLevel level) {
+    CurrentSimdLevel() = std::min(level, DetectSimdLevel());
+}
+
+static void CheckSlotModulus(const char* op, uint64_t q) {
+    if (q >= (uint64_t(1) << MAX_SLOT_MODULUS_BITS)) {
+        throw std::invalid_argument(std::string(op) + ": modulus must be below 2^" + std::to_string(MAX_SLOT_MODULUS_BITS));
+    }
+}
+
+void VecAddMod(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q) {
+    CheckSlotModulus("VecAddMod", q);
+    switch (GetSimdLevel()) {
+#ifdef MULTIKEY_FHE_X86
+        case SIMD_AVX512:
+            return AddModAVX512(c, a, b, n, q);
+        case SIMD_AVX2:
+            return AddModAVX2(c, a, b, n, q);
+#endif
+        default:
+            return AddModScalar(c, a, b, n, q);
+    }
+}
+
+void VecSubMod(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q) {
+    CheckSlotModulus("VecSubMod", q);
+    switch (GetSimdLevel()) {
+#ifdef MULTIKEY_FHE_X86
+        case SIMD_AVX512:
+            return SubModAVX512(c, a, b, n, q);
+        case SIMD_AVX2:
+            return SubModAVX2(c, a, b, n, q);
+#endif
+        default:
+            return SubModScalar(c, a, b, n, q);
+    }
+}
+
+void VecMulMod(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q) {
+    CheckSlotModulus("VecMulMod", q);
+    if (q >= (uint64_t(1) << 31)) {
+        return MulModScalar(c, a, b, n, q);
+    }
+    switch (GetSimdLevel()) {
+#ifdef MULTIKEY_FHE_X86
+        case SIMD_AVX512:
+            return MulModAVX512(c, a, b, n, q);
+        case SIMD_AVX2:
+            return MulModAVX2(c, a, b, n, q);
+#endif
+        default:
+            return MulModScalar(c, a, b, n, q);
+    }
+}
+
+// ---- 遅延剰余の和 ----
+
+// get(k) が k 番目の多項式を返す (MKCiphertext の列を Poly の列にコピーせずに足すため)
+template <typename Get>
+static Poly LazySum(size_t count, Get get) {
+    if (count == 0) {
+        throw std::invalid_argument("EvaluateSum: no ciphertexts");
+    }
+    const Poly& first = get(0);
+    const uint64_t q = first.GetModulus().ConvertToInt();
+    const size_t n = first.GetLength();
+    for (size_t k = 1; k < count; ++k) {
+        const Poly& ct = get(k);
+        if (ct.GetModulus() != first.GetModulus() || ct.GetLength() != n || ct.GetFormat() != first.GetFormat()) {
+            throw std::invalid_argument("EvaluateSum: ciphertexts do not share parameters and format");
+        }
+    }
+    Poly result(first.GetParams(), first.GetFormat(), true);
+    uint64_t* out = SlotData(result);
+#pragma omp parallel
+    {
+        LazyAccumulator acc(n, q);
+#pragma omp for schedule(static) nowait
+        for (size_t k = 0; k < count; ++k) {
+            acc.Add(SlotData(get(k)));
+        }
+        const uint64_t* partial = acc.Reduce();
+#pragma omp critical
+        VecAddMod(out, out, partial, n, q);
+    }
+    return result;
+}
+
+Poly EvaluateSum(const std::vector<Poly>& cts) {
+    return LazySum(cts.size(), [&cts](size_t k) -> const Poly& { return cts[k]; });
+}
+
+MKCiphertext EvaluateSum(const std::vector<MKCiphertext>& cts) {
+    if (cts.empty()) {
+        throw std::invalid_argument("EvaluateSum: no ciphertexts");
+    }
+    MKCiphertext result;
+    result.level = cts[0].level;
+    for (const MKCiphertext& ct : cts) {
+        if (ct.level != result.level) {
+            throw std::invalid_argument("EvaluateSum: ciphertexts are at different levels");
+        }
+        std::vector<unsigned int> parties;
+        std::set_union(result.parties.begin(), result.parties.end(), ct.parties.begin(), ct.parties.end(),
+                       std::back_inserter(parties));
+        result.parties = std::move(parties);
+    }
+    result.c = LazySum(cts.size(), [&cts](size_t k) -> const Poly& { return cts[k].c; });
+    result.noise = EstimateSumNoise(cts);
+    LogNoise("sum", result);
+    return result;
+}
@@ -0,0 +1,77 @@
+#ifndef MULTIKEY_FHE_SIMD_H
+#define MULTIKEY_FHE_SIMD_H
+
+#include "multikey_FHE_relin.h"
+#include <cstdint>
+#include <vector>
+
+// 評価形式のスロットごとの演算を SIMD で行う
+// NativeInteger は uint64_t 1つだけを持つので、Poly の係数は uint64_t の連続した配列として扱える。
+// 使う命令セットは実行時に CPU を見て選ぶ (AVX-512F > AVX2 > スカラー)。
+// 乗算の SIMD 版は q < 2^31 のとき 32 ビットの Montgomery 乗算を使い、それ以外はスカラーの Barrett 乗算に落ちる。
+enum SimdLevel {
+    SIMD_SCALAR,
+    SIMD_AVX2,
+    SIMD_AVX512
+};
+
+SimdLevel GetSimdLevel();
+// ベンチマーク・検証用に使う命令セットを変える (CPU が対応していないものは選べない)
+void SetSimdLevel(SimdLevel level);
+
+inline uint64_t* SlotData(Poly& p) {
+    return reinterpret_cast<uint64_t*>(&p[0]);
+}
+inline const uint64_t* SlotData(const Poly& p) {
+    return reinterpret_cast<const uint64_t*>(&p[0]);
+}
+
+// c[i] = a[i] op b[i] mod q (c は a, b と同じでもよい)
+// q は NativeInteger の Barrett 乗算 (スカラー版) が正しい範囲 q < 2^MAX_SLOT_MODULUS_BITS に限る (超えると例外)
+const unsigned int MAX_SLOT_MODULUS_BITS = 60;
+void VecAddMod(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q);
+void VecSubMod(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q);
+void VecMulMod(uint64_t* c, const uint64_t* a, const uint64_t* b, size_t n, uint64_t q);
+
+// 遅延剰余の累積 (多数の暗号文の和の共通部分)
+// スロットごとに 64 ビットのまま足し続け、桁あふれしうる項数に達したときだけ mod q を取る。
+// bound は1項の値の上限 (未満)。q で割った値を足すなら q、壊れているかもしれない b ビットの値なら 2^b。
+class LazyAccumulator {
+public:
+    LazyAccumulator(size_t n, uint64_t q, uint64_t bound = 0)
+        : m_acc(n, 0), m_q(q), m_max_terms(UINT64_MAX / (bound == 0 ? q : bound)) {}
+
+    void Add(const uint64_t* x) {
+        uint64_t* acc = m_acc.data();
+        const size_t n = m_acc.size();
+        for (size_t i = 0; i < n; ++i) {
+            acc[i] += x[i];
+        }
+        // q で割ったあとの値は q 以下なので1項として数える
+        if (++m_terms == m_max_terms) {
+            Reduce();
+        }
+    }
+    // 全スロットを mod q にしてその配列を返す (そのあとも足し続けられる)
+    const uint64_t* Reduce() {
+        for (uint64_t& a : m_acc) {
+            a %= m_q;
+        }
+        m_terms = 1;
+        return m_acc.data();
+    }
+
+private:
+    std::vector<uint64_t> m_acc;
+    uint64_t m_q;
+    uint64_t m_max_terms;
+    uint64_t m_terms = 0;
+};
+
+// 多数の暗号文の和
+// スロットごとに 64 ビットのまま足し続け、桁あふれしうる項数に達したときだけ mod q を取る。
+// 暗号文の列はスレッドごとに分けて部分和を取り、最後に足し合わせる。
+Poly EvaluateSum(const std::vector<Poly>& cts);
+MKCiphertext EvaluateSum(const std::vector<MKCiphertext>& cts);
+
+#endif
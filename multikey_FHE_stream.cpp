@@ -0,0 +1,263 @@
+#include "multikey_FHE_stream.h"
+#include "multikey_FHE_noise.h"
+#include "multikey_FHE_simd.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <omp.h>
+
+using namespace std;
+
+static uint64_t ElapsedNs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+}
+
+StreamPipeline::StreamPipeline(const std::vector<Poly>& pk, std::shared_ptr<ILNativeParams> params,
+                               const StreamConfig& config)
+    : m_pk(pk), m_params(std::move(params)), m_config(config) {
+    if (m_pk.empty()) {
+        throw std::invalid_argument("StreamPipeline: no public keys");
+    }
+    if (m_config.workers == 0) {
+        m_config.workers = static_cast<unsigned int>(omp_get_max_threads());
+    }
+    m_config.queue_capacity = std::max<size_t>(m_config.queue_capacity, 1);
+    m_config.batch_size = std::max<size_t>(m_config.batch_size, 1);
+
+    const size_t n = m_params->GetRingDimension();
+    const uint64_t q = m_params->GetModulus().ConvertToInt();
+    for (unsigned int k = 0; k < m_config.workers; ++k) {
+        m_workers.push_back(std::make_unique<Worker>(n, q, m_pk.size()));
+    }
+    m_start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < m_workers.size(); ++k) {
+        m_workers[k]->thread = std::thread(&StreamPipeline::Run, this, k);
+    }
+}
+
+// Finish していなければ、溜まっているバッチを処理し終えてから止める
+StreamPipeline::~StreamPipeline() {
+    m_closed = true;
+    m_work.notify_all();
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+// ---- 取り込み段 ----
+
+// バッチは m_next の順に配り、配り先が一杯なら次のワーカーを試す。全員一杯のときだけ待つ
+void StreamPipeline::Push(const std::vector<StreamItem>& items) {
+    if (m_closed) {
+        throw std::logic_error("StreamPipeline::Push: pipeline is already finished");
+    }
+    for (const StreamItem& item : items) {
+        if (item.party >= m_pk.size()) {
+            throw std::out_of_range("StreamPipeline::Push: unknown party " + std::to_string(item.party));
+        }
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const size_t count = m_workers.size();
+    for (size_t offset = 0; offset < items.size(); offset += m_config.batch_size) {
+        const size_t end = std::min(items.size(), offset + m_config.batch_size);
+        std::vector<StreamItem> batch(items.begin() + offset, items.begin() + end);
+
+        // キューに入れる前に数える (先に数えないと、取り出した側の fetch_sub が先に走って 0 を下回る)
+        m_pending.fetch_add(1, std::memory_order_release);
+        const size_t first = m_next.fetch_add(1, std::memory_order_relaxed) % count;
+        bool pushed = false;
+        for (size_t k = 0; k < count && !pushed; ++k) {
+            Worker& worker = *m_workers[(first + k) % count];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (worker.queue.size() < m_config.queue_capacity) {
+                worker.queue.push_back(std::move(batch));
+                pushed = true;
+            }
+        }
+        if (!pushed) {
+            m_stats.ingest_waits.fetch_add(1, std::memory_order_relaxed);
+            Worker& worker = *m_workers[first];
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            worker.not_full.wait(lock, [&] { return worker.queue.size() < m_config.queue_capacity; });
+            worker.queue.push_back(std::move(batch));
+        }
+        m_work.notify_one();
+    }
+    m_stats.ingest.items.fetch_add(items.size(), std::memory_order_relaxed);
+    m_stats.ingest.ns.fetch_add(ElapsedNs(start, std::chrono::steady_clock::now()), std::memory_order_relaxed);
+}
+
+// ---- 暗号化・部分集計段 ----
+
+// 自分のキューの先頭から取り、空なら他のワーカーのキューの末尾から盗む (同時に2つのロックは持たない)
+bool StreamPipeline::Take(size_t index, std::vector<StreamItem>& batch) {
+    const size_t count = m_workers.size();
+    for (size_t k = 0; k < count; ++k) {
+        Worker& victim = *m_workers[(index + k) % count];
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.queue.empty()) {
+                continue;
+            }
+            if (k == 0) {
+                batch = std::move(victim.queue.front());
+                victim.queue.pop_front();
+            } else {
+                batch = std::move(victim.queue.back());
+                victim.queue.pop_back();
+            }
+        }
+        victim.not_full.notify_one();
+        m_pending.fetch_sub(1, std::memory_order_acq_rel);
+        if (k != 0) {
+            m_stats.steals.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+    return false;
+}
+
+// 時間を測る間隔 (この個数に1個だけ、暗号化と集計を別々に測る)
+static const size_t STREAM_TIMING_SAMPLE = 16;
+
+// 1つずつ scratch に暗号化し、部分和 (遅延剰余の LazyAccumulator) に足す
+// 時計はバッチ全体の前後と、STREAM_TIMING_SAMPLE 個に1個の標本でだけ読み、
+// バッチ全体の時間を標本の比で暗号化と集計に分ける
+void StreamPipeline::Process(Worker& worker, const std::vector<StreamItem>& batch, Poly& scratch) {
+    uint64_t sampled_encrypt_ns = 0, sampled_aggregate_ns = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < batch.size(); ++k) {
+        const StreamItem& item = batch[k];
+        if (k % STREAM_TIMING_SAMPLE != 0) {
+            EncryptInto(scratch, m_pk[item.party], item.bit & 1, m_params);
+            worker.acc.Add(SlotData(scratch));
+            ++worker.counts[item.party];
+            continue;
+        }
+        const auto t0 = std::chrono::steady_clock::now();
+        EncryptInto(scratch, m_pk[item.party], item.bit & 1, m_params);
+        const auto t1 = std::chrono::steady_clock::now();
+        worker.acc.Add(SlotData(scratch));
+        ++worker.counts[item.party];
+        const auto t2 = std::chrono::steady_clock::now();
+        sampled_encrypt_ns += ElapsedNs(t0, t1);
+        sampled_aggregate_ns += ElapsedNs(t1, t2);
+    }
+    const uint64_t total_ns = ElapsedNs(start, std::chrono::steady_clock::now());
+    const uint64_t sampled_ns = sampled_encrypt_ns + sampled_aggregate_ns;
+    const uint64_t aggregate_ns =
+        sampled_ns == 0 ? 0 : static_cast<uint64_t>(static_cast<double>(total_ns) * sampled_aggregate_ns / sampled_ns);
+
+    m_stats.encrypt.items.fetch_add(batch.size(), std::memory_order_relaxed);
+    m_stats.encrypt.ns.fetch_add(total_ns - aggregate_ns, std::memory_order_relaxed);
+    m_stats.aggregate.items.fetch_add(batch.size(), std::memory_order_relaxed);
+    m_stats.aggregate.ns.fetch_add(aggregate_ns, std::memory_order_relaxed);
+}
+
+// 仕事がないときだけ m_idle_mutex で待つ。取り込みの通知を取りこぼしても短い時間で見直す
+void StreamPipeline::Run(size_t index) {
+    Worker& worker = *m_workers[index];
+    Poly scratch(m_params, EVALUATION, true);
+    std::vector<StreamItem> batch;
+    while (true) {
+        if (Take(index, batch)) {
+            Process(worker, batch, scratch);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_idle_mutex);
+        if (m_closed && m_pending.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+        m_work.wait_for(lock, std::chrono::microseconds(200),
+                        [this] { return m_closed || m_pending.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+// ---- 最終集計・復号段 ----
+
+MKCiphertext StreamPipeline::Finish() {
+    if (m_closed.exchange(true)) {
+        throw std::logic_error("StreamPipeline::Finish: called twice");
+    }
+    m_work.notify_all();
+    for (auto& worker : m_workers) {
+        worker->thread.join();
+    }
+    m_end = std::chrono::steady_clock::now();
+
+    std::vector<Poly> partials;
+    std::vector<uint64_t> counts(m_pk.size(), 0);
+    for (auto& worker : m_workers) {
+        if (std::all_of(worker->counts.begin(), worker->counts.end(), [](uint64_t c) { return c == 0; })) {
+            continue;
+        }
+        Poly partial(m_params, EVALUATION, true);
+        const uint64_t* reduced = worker->acc.Reduce();
+        std::copy(reduced, reduced + m_params->GetRingDimension(), SlotData(partial));
+        partials.push_back(std::move(partial));
+        for (size_t party = 0; party < counts.size(); ++party) {
+            counts[party] += worker->counts[party];
+        }
+    }
+    if (partials.empty()) {
+        return EncryptConstant(0, m_params);
+    }
+
+    // ワーカーごとの部分和を木で足す (段ごとに組の足し算を並列に行う)
+    for (size_t stride = 1; stride < partials.size(); stride *= 2) {
+#pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < partials.size() - stride; i += 2 * stride) {
+            AddInPlace(partials[i], partials[i + stride]);
+        }
+    }
+
+    // 雑音の見積もり: ユーザごとの新しい暗号文の数から求める
+    MKCiphertext result;
+    std::vector<NoiseTerm> terms;
+    const unsigned int degree = m_params->GetRingDimension();
+    const double fresh = FreshNoise(degree);
+    for (unsigned int party = 0; party < counts.size(); ++party) {
+        if (counts[party] == 0) {
+            continue;
+        }
+        terms.push_back({party, counts[party], fresh});
+        result.parties.push_back(party);
+    }
+    result.c = std::move(partials[0]);
+    result.noise = EstimateSumNoise(degree, terms);
+    LogNoise("stream", result);
+
+    m_stats.finalize.items.fetch_add(1, std::memory_order_relaxed);
+    m_stats.finalize.ns.fetch_add(ElapsedNs(m_end, std::chrono::steady_clock::now()), std::memory_order_relaxed);
+    return result;
+}
+
+int StreamPipeline::FinishAndDecrypt(const DecryptionKey& key) {
+    const MKCiphertext result = Finish();
+    const auto start = std::chrono::steady_clock::now();
+    const int message = Decrypt(key, result.c);
+    m_stats.finalize.ns.fetch_add(ElapsedNs(start, std::chrono::steady_clock::now()), std::memory_order_relaxed);
+    return message;
+}
+
+// スループットは経過時間 (作ってから Finish まで) あたりの件数。busy は全スレッドがその段で使った時間の合計
+void StreamPipeline::PrintStats(std::ostream& out) const {
+    const auto end = m_closed ? m_end : std::chrono::steady_clock::now();
+    const double wall_ns = std::max<double>(static_cast<double>(ElapsedNs(m_start, end)), 1.0);
+    const std::pair<const char*, const StageCounter*> stages[] = {
+        {"ingest", &m_stats.ingest},
+        {"encrypt", &m_stats.encrypt},
+        {"aggregate", &m_stats.aggregate},
+        {"finalize", &m_stats.finalize},
+    };
+    out << "stream: " << m_workers.size() << " workers, " << m_stats.steals.load() << " steals, "
+        << m_stats.ingest_waits.load() << " ingest waits, " << wall_ns / 1e6 << " ms" << std::endl;
+    for (const auto& stage : stages) {
+        const uint64_t items = stage.second->items.load();
+        const double busy_ns = static_cast<double>(stage.second->ns.load());
+        out << "  " << stage.first << ": " << items << " items, busy " << busy_ns / 1e6 << " ms, "
+            << items * 1e9 / wall_ns << " items/s" << std::endl;
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef MULTIKEY_FHE_STREAM_H
+#define MULTIKEY_FHE_STREAM_H
+
+#include "multikey_FHE_relin.h"
+#include "multikey_FHE_batch.h"
+#include "multikey_FHE_simd.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iosfwd>
+#include <mutex>
+#include <thread>
+
+// ストリーミング集計のパイプライン
+// 多数のユーザが1ビットずつ Encrypt(h_i, ...) し、サーバがそれを EvaluateAdd で足し続ける処理を
+//   取り込み (Push) -> 暗号化 -> 部分集計 -> 最終集計・復号 (Finish)
+// の段に分ける。取り込んだビットはバッチにしてワーカーごとの有界キューに順に配る。
+// ワーカーは自分のキューの先頭から取り、空なら他のワーカーのキューの末尾から盗む (work stealing)。
+// 暗号文はワーカー自身の部分和 (評価形式のスロットを 64 ビットのまま足す遅延剰余) に足すだけなので、
+// 途中に全体のロックや逐次の畳み込みはなく、部分和は Finish で木の形に足し合わせる。
+struct StreamItem {
+    unsigned int party; // 暗号化に使う公開鍵の番号
+    int bit;
+};
+
+struct StreamConfig {
+    unsigned int workers = 0;   // 0 なら OpenMP のスレッド数
+    size_t queue_capacity = 16; // ワーカー1つのキューに溜められるバッチ数
+    size_t batch_size = 256;    // 1バッチのビット数
+};
+
+// 段ごとの計数 (ワーカーはバッチごとにまとめて relaxed で足すので、ホットパスで競合しない)
+struct StageCounter {
+    std::atomic<uint64_t> items{0};
+    std::atomic<uint64_t> ns{0}; // その段で使った時間 (全スレッドの合計)
+};
+
+struct StreamStats {
+    StageCounter ingest, encrypt, aggregate, finalize;
+    std::atomic<uint64_t> steals{0};      // 他のワーカーから盗んだバッチ数
+    std::atomic<uint64_t> ingest_waits{0}; // 全キューが一杯で取り込みが待った回数
+};
+
+class StreamPipeline {
+public:
+    // pk[i] はユーザ i の公開鍵 (評価形式)。作った時点でワーカーが動き始める
+    StreamPipeline(const std::vector<Poly>& pk, std::shared_ptr<ILNativeParams> params,
+                   const StreamConfig& config = StreamConfig());
+    ~StreamPipeline();
+    StreamPipeline(const StreamPipeline&) = delete;
+    StreamPipeline& operator=(const StreamPipeline&) = delete;
+
+    // 取り込み段 (複数のスレッドから呼んでよい)。キューが一杯なら空くまで待つ
+    void Push(const std::vector<StreamItem>& items);
+    // 取り込みを閉じ、残りのバッチを処理し終えてから部分和を合わせた暗号文を返す (1回だけ呼べる)
+    // 1つも取り込んでいなければ 0 の自明な暗号文
+    MKCiphertext Finish();
+    // Finish して合成鍵で復号する (全ビットの XOR)
+    int FinishAndDecrypt(const DecryptionKey& key);
+
+    const StreamStats& Stats() const { return m_stats; }
+    // 段ごとの件数・時間・スループット
+    void PrintStats(std::ostream& out) const;
+
+private:
+    struct Worker {
+        Worker(size_t n, uint64_t q, size_t parties) : acc(n, q), counts(parties, 0) {}
+
+        std::mutex mutex;
+        std::condition_variable not_full;
+        std::deque<std::vector<StreamItem>> queue;
+        LazyAccumulator acc;          // 部分和 (評価形式のスロット)
+        std::vector<uint64_t> counts; // ユーザごとに足した暗号文の数 (雑音の見積もり用)
+        std::thread thread;
+    };
+
+    void Run(size_t index);
+    bool Take(size_t index, std::vector<StreamItem>& batch);
+    void Process(Worker& worker, const std::vector<StreamItem>& batch, Poly& scratch);
+
+    std::vector<Poly> m_pk;
+    std::shared_ptr<ILNativeParams> m_params;
+    StreamConfig m_config;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<size_t> m_next{0};    // 次にバッチを配るワーカー
+    std::atomic<size_t> m_pending{0}; // キューに入っている (入れかけを含む) バッチ数
+    std::atomic<bool> m_closed{false};
+    // 仕事がないワーカーだけが待つ (ホットパスでは触らない)
+    std::mutex m_idle_mutex;
+    std::condition_variable m_work;
+    StreamStats m_stats;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_end;
+};
+
+#endif
@@ -1,32 +1,27 @@
-#include "openfhe.h"
+#include "multikey_FHE.h"
+#include "multikey_FHE_dcrt.h"
+#include "multikey_FHE_relin.h"
+#include "multikey_FHE_modswitch.h"
+#include "multikey_FHE_noise.h"
+#include "multikey_FHE_sampler.h"
+#include "multikey_FHE_batch.h"
+#include "multikey_FHE_party.h"
+#include "multikey_FHE_circuit.h"
+#include "multikey_FHE_pool.h"
+#include "multikey_FHE_simd.h"
+#include "multikey_FHE_fixed.h"
+#include "multikey_FHE_keypool.h"
+#include "multikey_FHE_serial.h"
+#include "multikey_FHE_stream.h"
 #include <iostream>
 #include <vector>
 #include <random>
 #include <memory>
-#include "math/discretegaussiangenerator.h"
-
-// using宣言
-using lbcrypto::NativeInteger;
-using lbcrypto::ILNativeParams;
-using lbcrypto::NativePoly;
-
-using lbcrypto::DiscreteGaussianGeneratorImpl;
-using lbcrypto::NativeVector;
-using lbcrypto::RootOfUnity;
-
-// このコードでは低レベルな多項式を直接扱うため、NativePolyをPolyとして定義
-using Poly = NativePoly;
+#include <cstdio>
+#include <sstream>
 
 using namespace std;
 
-// 関数のプロトタイプ宣言
-Poly GenerateSmallPoly(unsigned int degree, std::shared_ptr<ILNativeParams> params);
-bool KeyGen(unsigned int degree, std::shared_ptr<ILNativeParams> params, Poly& sk, Poly& pk);
-Poly Encrypt(const Poly& pk, int message, unsigned int degree, std::shared_ptr<ILNativeParams> params);
-int Decrypt(const Poly& sk_combined, const Poly& c);
-Poly EvaluateAdd(const Poly& c1, const Poly& c2);
-Poly EvaluateMult(const Poly& c1, const Poly& c2);
-
 //加算器を
 
 int main(int argc, char* argv[]) {
@@ -107,80 +102,353 @@ int main(int argc, char* argv[]) {
         std::cout << "--> Multiplication FAILURE" << std::endl;
     }
 
-    return 0;
-}
+    // =================================================================
+    // 6. パック暗号化 (1暗号文に degree ビット)
+    // =================================================================
+    std::vector<int> bits_zero = {0, 1, 0, 1, 1, 0, 0, 1};
+    std::vector<int> bits_one  = {1, 1, 0, 0, 1, 0, 1, 0};
+    Poly c_packed_zero = EncryptPacked(h_zero, bits_zero, degree, params);
+    Poly c_packed_one = EncryptPacked(h_one, bits_one, degree, params);
 
-// ガウス分布に従う「小さい」係数の多項式を生成
-Poly GenerateSmallPoly(unsigned int degree, std::shared_ptr<ILNativeParams> params) {
-    DiscreteGaussianGeneratorImpl<NativeVector> dgg(3.2);
-    Poly result(dgg, params, COEFFICIENT);
-    return result;
-}
+    // スロットごとの XOR
+    std::vector<int> dec_packed_add = DecryptPacked(f_combined, EvaluateAdd(c_packed_zero, c_packed_one), bits_zero.size());
+    // 単一ビット暗号文 (c_one = Enc(1)) との積はスロットごとの AND
+    std::vector<int> dec_packed_mult = DecryptPacked(f_combined, EvaluateMult(c_packed_zero, c_one), bits_zero.size());
+
+    std::cout << std::endl;
+    bool packed_ok = true;
+    for (size_t i = 0; i < bits_zero.size(); ++i) {
+        packed_ok &= dec_packed_add[i] == (bits_zero[i] ^ bits_one[i]);
+        packed_ok &= dec_packed_mult[i] == (bits_zero[i] & m_one);
+    }
+    std::cout << "Packed Add/Mult (" << bits_zero.size() << " slots): " << (packed_ok ? "SUCCESS" : "FAILURE") << std::endl;
 
-// 鍵生成
-bool KeyGen(unsigned int degree, std::shared_ptr<ILNativeParams> params, Poly& sk, Poly& pk) {
-    Poly f_prime = GenerateSmallPoly(degree, params);
-    Poly g = GenerateSmallPoly(degree, params);
-    Poly f = f_prime * 2 + 1;
+    // =================================================================
+    // 7. RNS (DCRTPoly) バックエンド: N=4096, 50ビット素数 x 3
+    // =================================================================
+    const unsigned int dcrt_degree = 4096;
+    auto dcrt_params = GenerateDCRTParams(dcrt_degree, 3, 50);
+    DCRTPoly F_zero, H_zero, F_one, H_one;
+    while (!KeyGen(dcrt_degree, dcrt_params, F_zero, H_zero));
+    while (!KeyGen(dcrt_degree, dcrt_params, F_one, H_one));
+    DCRTPoly F_combined = F_zero * F_one;
 
-    
-    // ★ 修正点: 逆元を計算する前に、まず存在するかどうかをチェックする ★
-    // このチェックにより、ゼロ除算が原因のクラッシュを未然に防ぎます。
-    if (!f.InverseExists()) {
-        return false; // 逆元が存在しない場合は、失敗としてmain関数に通知し、再試行を促す
+    DCRTPoly C_zero = Encrypt(H_zero, m_zero, dcrt_degree, dcrt_params);
+    DCRTPoly C_one = Encrypt(H_one, m_one, dcrt_degree, dcrt_params);
+    int dcrt_add = Decrypt(F_combined, EvaluateAdd(C_zero, C_one));
+    int dcrt_mult = Decrypt(F_combined, EvaluateMult(C_zero, C_one));
+    std::cout << "DCRT Add (0+1): " << dcrt_add << ", Mult (0*1): " << dcrt_mult << " -> "
+              << ((dcrt_add == expected_add && dcrt_mult == expected_mult) ? "SUCCESS" : "FAILURE") << std::endl;
+
+    // =================================================================
+    // 8. 再線形化: 同じユーザの暗号文を掛けても固定の合成鍵で復号できる
+    // =================================================================
+    const NativeInteger relin_modulus = lbcrypto::LastPrime<NativeInteger>(40, cyclotomic_order);
+    auto relin_params = std::make_shared<ILNativeParams>(cyclotomic_order, relin_modulus,
+                                                         RootOfUnity<NativeInteger>(cyclotomic_order, relin_modulus));
+    std::vector<Poly> relin_sk(2), relin_pk(2);
+    std::vector<EvalKey> evks;
+    for (unsigned int party = 0; party < 2; ++party) {
+        while (!KeyGen(degree, relin_params, relin_sk[party], relin_pk[party]));
+        evks.push_back(EvalKeyGen(relin_sk[party], relin_pk[party], degree, relin_params));
     }
+    Poly relin_combined = relin_sk[0] * relin_sk[1];
 
-        
-    
-    // 逆元が存在することを確認した上で、計算を実行する
-    try {
-        f.SwitchFormat();
-        g.SwitchFormat();
-    
-        Poly f_inv = f.MultiplicativeInverse();
-        
-        sk = f;
-        pk = g * 2 * f_inv;
-        return true; // 成功
-    } catch (const std::exception& e) {
-        // InverseExists()でチェック済みですが、念のためtry-catchも残します
-        return false; // 予期せぬエラーで失敗
+    int m_zero_2 = 1;
+    MKCiphertext r_zero = EncryptMK(relin_pk[0], 0, m_zero, degree, relin_params);
+    MKCiphertext r_one = EncryptMK(relin_pk[1], 1, m_one, degree, relin_params);
+    MKCiphertext r_zero_2 = EncryptMK(relin_pk[0], 0, m_zero_2, degree, relin_params);
+
+    // (a*b)*c と (a+b)*c: ユーザ 'zero' の鍵が2回現れるので再線形化される
+    int dec_relin_mult = Decrypt(relin_combined, EvaluateMult(EvaluateMult(r_zero, r_one, evks), r_zero_2, evks));
+    int dec_relin_mix = Decrypt(relin_combined, EvaluateMult(EvaluateAdd(r_zero, r_one), r_zero_2, evks));
+    int expected_relin_mult = m_zero * m_one * m_zero_2;
+    int expected_relin_mix = ((m_zero + m_one) * m_zero_2) % 2;
+    std::cout << "Relinearized mult: " << dec_relin_mult << " (Expected: " << expected_relin_mult << "), mix: "
+              << dec_relin_mix << " (Expected: " << expected_relin_mix << ") -> "
+              << ((dec_relin_mult == expected_relin_mult && dec_relin_mix == expected_relin_mix) ? "SUCCESS" : "FAILURE")
+              << std::endl;
+
+    // =================================================================
+    // 9. 法の段: 乗算ごとに 50 -> 40 -> 30 ビットの法へ下げる
+    // =================================================================
+    ModulusChain chain = GenerateModulusChain(degree, {50, 40, 30});
+    std::vector<LeveledKeyPair> leveled_keys(2);
+    std::vector<std::vector<EvalKey>> leveled_evks(2);
+    for (unsigned int party = 0; party < 2; ++party) {
+        while (!KeyGen(degree, chain, leveled_keys[party]));
+        leveled_evks[party] = EvalKeyGen(leveled_keys[party], degree, chain);
     }
-}
 
-// 暗号化
-Poly Encrypt(const Poly& pk, int message, unsigned int degree, std::shared_ptr<ILNativeParams> params) {
-    Poly s = GenerateSmallPoly(degree, params);
-    Poly e = GenerateSmallPoly(degree, params);
-    Poly m(params, COEFFICIENT, true);
-    m[0] = message;
-    s.SwitchFormat();
-    e.SwitchFormat();
-    m.SwitchFormat();
-    Poly c = pk * s + e * 2 + m;
-    return c;
-}
+    MKCiphertext l_zero = EncryptMK(leveled_keys[0].pk[0], 0, m_zero, degree, chain.levels[0]);
+    MKCiphertext l_one = EncryptMK(leveled_keys[1].pk[0], 1, m_one, degree, chain.levels[0]);
+    MKCiphertext l_zero_2 = EncryptMK(leveled_keys[0].pk[0], 0, m_zero_2, degree, chain.levels[0]);
 
-// 復号
-int Decrypt(const Poly& sk_combined, const Poly& c) {
-    Poly mu = c * sk_combined;
-    mu.SwitchFormat();
-    auto params = mu.GetParams();
-    NativeInteger constant_term = mu[0];
-    int64_t result = constant_term.ConvertToInt();
-    int64_t modulus_int = params->GetModulus().ConvertToInt();
-    if (result > modulus_int / 2) {
-        result -= modulus_int;
-    }
-    return (result % 2 + 2) % 2;
-}
+    // (a+b)*c*c: 2回の乗算で段 2 まで下がる
+    MKCiphertext l_result = EvaluateMult(EvaluateMult(EvaluateAdd(l_zero, l_one, chain), l_zero_2, leveled_evks, chain),
+                                         l_zero_2, leveled_evks, chain);
+    Poly leveled_combined = leveled_keys[0].sk[l_result.level] * leveled_keys[1].sk[l_result.level];
+    int dec_leveled = Decrypt(leveled_combined, l_result);
+    int expected_leveled = ((m_zero + m_one) * m_zero_2 * m_zero_2) % 2;
+    std::cout << "Mod-switched (a+b)*c*c at level " << l_result.level << ": " << dec_leveled
+              << " (Expected: " << expected_leveled << ") -> " << (dec_leveled == expected_leveled ? "SUCCESS" : "FAILURE")
+              << std::endl;
 
-// 同型加算
-Poly EvaluateAdd(const Poly& c1, const Poly& c2) {
-    return c1 + c2;
-}
+    // =================================================================
+    // 10. 雑音の見積もりと実測 (デバッグモードで std::cerr に出力)
+    // =================================================================
+    SetNoiseDebugKeys({leveled_keys[0].sk, leveled_keys[1].sk});
+    MKCiphertext n_result = EvaluateMult(EvaluateAdd(l_zero, l_one, chain), l_zero_2, leveled_evks, chain);
+    SetNoiseDebugKeys({});
+    std::cout << "Noise budget after (a+b)*c: " << NoiseBudget(n_result) << " bits (level " << n_result.level
+              << "), can multiply again: " << (CanMultiply(n_result, l_zero_2, 4) ? "yes" : "no") << std::endl;
+
+    // =================================================================
+    // 11. 3値 {-1, 0, 1} の秘密鍵・雑音
+    // =================================================================
+    SetSmallPolyDistribution(TERNARY);
+    Poly t_sk_zero, t_pk_zero, t_sk_one, t_pk_one;
+    while (!KeyGen(degree, params, t_sk_zero, t_pk_zero));
+    while (!KeyGen(degree, params, t_sk_one, t_pk_one));
+    Poly t_combined = t_sk_zero * t_sk_one;
+    int dec_ternary = Decrypt(t_combined, EvaluateMult(Encrypt(t_pk_zero, m_zero, degree, params),
+                                                       Encrypt(t_pk_one, m_one, degree, params)));
+    SetSmallPolyDistribution(GAUSSIAN);
+    std::cout << "Ternary keys (0*1): " << dec_ternary << " (Expected: " << expected_mult << ") -> "
+              << (dec_ternary == expected_mult ? "SUCCESS" : "FAILURE") << std::endl;
+
+    // =================================================================
+    // 12. まとめて暗号化
+    // =================================================================
+    std::vector<int> batch_messages(1000);
+    for (size_t i = 0; i < batch_messages.size(); ++i) {
+        batch_messages[i] = (i * 7 + 3) % 5 < 2;
+    }
+    std::vector<Poly> batch = EncryptBatch(h_zero, batch_messages, degree, params);
+    std::vector<int> batch_bits = DecryptBatch(PrecomputeDecryptionKey(f_zero), batch);
+    size_t batch_errors = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        batch_errors += batch_bits[i] != batch_messages[i];
+        batch_errors += Decrypt(f_zero, batch[i]) != batch_messages[i];
+    }
+    std::cout << "EncryptBatch/DecryptBatch (" << batch.size() << " bits): " << batch_errors << " errors -> "
+              << (batch_errors == 0 ? "SUCCESS" : "FAILURE") << std::endl;
+
+    // =================================================================
+    // 13. k ユーザ: 並列鍵生成・木による合成鍵・分散復号
+    // =================================================================
+    const unsigned int num_parties = 5;
+    MultiKeyContext ctx = GenerateMultiKeyContext(num_parties, degree, relin_params);
+    MKCiphertext k_sum = EncryptMK(ctx.pk[0], 0, 1, degree, relin_params);
+    int expected_sum = 1;
+    for (unsigned int party = 1; party < num_parties; ++party) {
+        int bit = party % 2;
+        k_sum = EvaluateAdd(k_sum, EncryptMK(ctx.pk[party], party, bit, degree, relin_params));
+        expected_sum ^= bit;
+    }
+    int dec_tree = Decrypt(CombinedKey(ctx, k_sum.parties), k_sum);
+    int dec_distributed = DistributedDecrypt(ctx, k_sum);
+    std::cout << num_parties << " parties sum: combined " << dec_tree << ", distributed " << dec_distributed
+              << " (Expected: " << expected_sum << ") -> "
+              << (dec_tree == expected_sum && dec_distributed == expected_sum ? "SUCCESS" : "FAILURE") << std::endl;
+
+    // =================================================================
+    // 14. 回路: 2ビットの加算器 (順次桁上げ・桁上げ先見) と比較器
+    // =================================================================
+    const int x_value = 3, y_value = 2;
+    Circuit circuit;
+    std::vector<size_t> x_bits = AddInputs(circuit, 2);
+    std::vector<size_t> y_bits = AddInputs(circuit, 2);
+    std::vector<size_t> ripple = RippleCarryAdder(circuit, x_bits, y_bits);
+    std::vector<size_t> lookahead = CarryLookaheadAdder(circuit, x_bits, y_bits);
+    circuit.outputs = ripple;
+    circuit.outputs.insert(circuit.outputs.end(), lookahead.begin(), lookahead.end());
+    circuit.outputs.push_back(LessThan(circuit, y_bits, x_bits));
+    circuit.outputs.push_back(Equal(circuit, x_bits, y_bits));
+
+    std::vector<MKCiphertext> circuit_inputs;
+    for (int i = 0; i < 2; ++i) {
+        circuit_inputs.push_back(EncryptMK(relin_pk[0], 0, (x_value >> i) & 1, degree, relin_params));
+    }
+    for (int i = 0; i < 2; ++i) {
+        circuit_inputs.push_back(EncryptMK(relin_pk[1], 1, (y_value >> i) & 1, degree, relin_params));
+    }
+    std::vector<MKCiphertext> circuit_outputs = EvaluateCircuit(circuit, circuit_inputs, MakeCircuitOps(evks));
+    int ripple_sum = 0, lookahead_sum = 0;
+    for (int i = 0; i < 3; ++i) {
+        ripple_sum |= Decrypt(relin_combined, circuit_outputs[i]) << i;
+        lookahead_sum |= Decrypt(relin_combined, circuit_outputs[3 + i]) << i;
+    }
+    int dec_less = Decrypt(relin_combined, circuit_outputs[6]);
+    int dec_equal = Decrypt(relin_combined, circuit_outputs[7]);
+    bool circuit_ok = ripple_sum == x_value + y_value && lookahead_sum == x_value + y_value &&
+                      dec_less == (y_value < x_value) && dec_equal == (x_value == y_value);
+    std::cout << "Circuit (depth " << MultiplicativeDepth(circuit) << "): " << x_value << "+" << y_value
+              << " = " << ripple_sum << " (ripple), " << lookahead_sum << " (lookahead), "
+              << y_value << "<" << x_value << ": " << dec_less << ", ==: " << dec_equal << " -> "
+              << (circuit_ok ? "SUCCESS" : "FAILURE") << std::endl;
+
+    // =================================================================
+    // 15. 同じバッファへの暗号化 (s, e はプールから借りるので確保は最初の1回だけ)
+    // =================================================================
+    Poly reused(params, EVALUATION, true);
+    size_t reuse_errors = 0;
+    for (int i = 0; i < 1000; ++i) {
+        EncryptInto(reused, h_zero, i & 1, params);
+        AddInPlace(reused, c_zero);
+        reuse_errors += Decrypt(f_zero, reused) != ((i & 1) ^ m_zero);
+    }
+    std::cout << "EncryptInto/AddInPlace (1000 rounds, pooled polys: " << PooledPolyCount() << "): "
+              << reuse_errors << " errors -> " << (reuse_errors == 0 ? "SUCCESS" : "FAILURE") << std::endl;
+
+    // =================================================================
+    // 16. 多数の暗号文の和 (遅延剰余、SIMD カーネル)
+    // =================================================================
+    Poly tally = EvaluateSum(batch);
+    Poly tally_sequential = batch[0];
+    int expected_tally = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (i > 0) {
+            tally_sequential = EvaluateAdd(tally_sequential, batch[i]);
+        }
+        expected_tally ^= batch_messages[i];
+    }
+    int dec_tally = Decrypt(f_zero, tally);
+    std::cout << "EvaluateSum (" << batch.size() << " ciphertexts, SIMD level " << GetSimdLevel() << "): " << dec_tally
+              << " (Expected: " << expected_tally << ") -> "
+              << (dec_tally == expected_tally && tally == tally_sequential ? "SUCCESS" : "FAILURE") << std::endl;
+
+    // SIMD カーネルと厳密な値 (unsigned __int128 で計算) の比較
+    // 法は、32 ビット Montgomery 乗算を使う最大級の素数 2^31 - 1、スカラーに落ちる最小級の素数 2^31 + 11、
+    // 対応する上限に近い素数 2^60 - 93。長さ 8 の倍数でない配列 (端の処理) で、スカラーを含む CPU が
+    // 対応する全命令セットを確かめる
+    const SimdLevel detected_level = GetSimdLevel();
+    const size_t kernel_length = 37;
+    std::mt19937_64 kernel_rng(16);
+    size_t kernel_mismatches = 0;
+    for (uint64_t q : {modulus, uint64_t(2147483647), uint64_t(2147483659), uint64_t(1152921504606846883)}) {
+        std::vector<uint64_t> a(kernel_length), b(kernel_length);
+        for (size_t i = 0; i < kernel_length; ++i) {
+            a[i] = kernel_rng() % q;
+            b[i] = kernel_rng() % q;
+        }
+        a[0] = b[0] = q - 1;
+        a[kernel_length - 1] = 0;
+        std::vector<uint64_t> add_ref(kernel_length), sub_ref(kernel_length), mul_ref(kernel_length);
+        for (size_t i = 0; i < kernel_length; ++i) {
+            add_ref[i] = static_cast<uint64_t>((static_cast<unsigned __int128>(a[i]) + b[i]) % q);
+            sub_ref[i] = static_cast<uint64_t>((static_cast<unsigned __int128>(a[i]) + q - b[i]) % q);
+            mul_ref[i] = static_cast<uint64_t>((static_cast<unsigned __int128>(a[i]) * b[i]) % q);
+        }
+        for (int level = SIMD_SCALAR; level <= detected_level; ++level) {
+            std::vector<uint64_t> sum(kernel_length), difference(kernel_length), product(kernel_length);
+            SetSimdLevel(static_cast<SimdLevel>(level));
+            VecAddMod(sum.data(), a.data(), b.data(), kernel_length, q);
+            VecSubMod(difference.data(), a.data(), b.data(), kernel_length, q);
+            VecMulMod(product.data(), a.data(), b.data(), kernel_length, q);
+            kernel_mismatches += (sum != add_ref) + (difference != sub_ref) + (product != mul_ref);
+        }
+    }
+    SetSimdLevel(detected_level);
+    std::cout << "SIMD kernels vs exact (levels up to " << detected_level << ", length " << kernel_length
+              << "): " << kernel_mismatches << " mismatches -> " << (kernel_mismatches == 0 ? "SUCCESS" : "FAILURE")
+              << std::endl;
 
-// 同型乗算
-Poly EvaluateMult(const Poly& c1, const Poly& c2) {
-    return c1 * c2;
-}
\ No newline at end of file
+    // =================================================================
+    // 17. 次数・法を固定した多項式 FixedPoly<8, 320417>
+    // =================================================================
+    using Fixed = FixedPoly<8, 320417>;
+    Fixed x_sk_zero, x_pk_zero, x_sk_one, x_pk_one;
+    while (!KeyGen(x_sk_zero, x_pk_zero));
+    while (!KeyGen(x_sk_one, x_pk_one));
+    Fixed x_combined = x_sk_zero * x_sk_one;
+    Fixed x_zero = Encrypt(x_pk_zero, m_zero);
+    Fixed x_one = Encrypt(x_pk_one, m_one);
+    int dec_fixed_add = Decrypt(x_combined, EvaluateAdd(x_zero, x_one));
+    int dec_fixed_mult = Decrypt(x_combined, EvaluateMult(x_zero, x_one));
+    // NativePoly と同じ環の積になっているか (変換してから掛けても、掛けてから変換しても同じ)
+    bool fixed_matches = FromPoly<8, 320417>(f_combined) == FromPoly<8, 320417>(f_zero) * FromPoly<8, 320417>(f_one) &&
+                         Decrypt(ToPoly(x_combined, params), ToPoly(EvaluateAdd(x_zero, x_one), params)) == dec_fixed_add;
+    std::cout << "FixedPoly<8, 320417> Add: " << dec_fixed_add << ", Mult: " << dec_fixed_mult << " (Expected: "
+              << expected_add << ", " << expected_mult << ") -> "
+              << (dec_fixed_add == expected_add && dec_fixed_mult == expected_mult && fixed_matches ? "SUCCESS" : "FAILURE")
+              << std::endl;
+
+    // =================================================================
+    // 18. 投機的な並列鍵生成と事前生成の鍵プール (保存・読み込み)
+    // =================================================================
+    Poly s_sk_zero, s_pk_zero;
+    KeyGenSpeculative(degree, params, s_sk_zero, s_pk_zero);
+    KeyPool key_pool(degree, params, 4);
+    key_pool.Start();
+    key_pool.WaitUntil(4);
+    const std::string key_file = "multikey_FHE_keys.bin";
+    key_pool.Save(key_file);
+    key_pool.Stop();
+
+    KeyPool loaded_pool(degree, params, 4);
+    loaded_pool.Load(key_file);
+    std::remove(key_file.c_str());
+    Poly p_sk_one, p_pk_one;
+    loaded_pool.Acquire(p_sk_one, p_pk_one);
+    int dec_pool = Decrypt(s_sk_zero * p_sk_one, EvaluateMult(Encrypt(s_pk_zero, m_zero, degree, params),
+                                                              Encrypt(p_pk_one, m_one, degree, params)));
+    std::cout << "KeyPool (saved/loaded " << loaded_pool.Size() + 1 << " keys) 0*1: " << dec_pool
+              << " (Expected: " << expected_mult << ") -> " << (dec_pool == expected_mult ? "SUCCESS" : "FAILURE")
+              << std::endl;
+
+    // =================================================================
+    // 19. 直列化 (係数を q のビット幅に詰める) とメモリマップした暗号文ストア
+    // =================================================================
+    std::stringstream serialized;
+    WriteCiphertext(serialized, r_zero);
+    const size_t serialized_bytes = serialized.str().size();
+    MKCiphertext r_zero_read = ReadCiphertext(serialized, relin_params);
+    bool serial_ok = r_zero_read.c == r_zero.c && r_zero_read.parties == r_zero.parties;
+
+    const std::string store_file = "multikey_FHE_store.bin";
+    std::remove(store_file.c_str());
+    {
+        CiphertextStore store(store_file, params);
+        for (const Poly& c : batch) {
+            store.Append(c);
+        }
+    }
+    CiphertextStore store(store_file, params);
+    Poly stored;
+    for (size_t i = 0; i < store.Size(); ++i) {
+        store.Get(i, stored);
+        serial_ok = serial_ok && stored == batch[i];
+    }
+    int dec_store = Decrypt(f_zero, EvaluateSum(store));
+    std::remove(store_file.c_str());
+    std::cout << "Serialization (" << serialized_bytes << " bytes/ciphertext), store of " << store.Size()
+              << ": sum " << dec_store << " (Expected: " << expected_tally << ") -> "
+              << (serial_ok && dec_store == expected_tally ? "SUCCESS" : "FAILURE") << std::endl;
+
+    // =================================================================
+    // 20. ストリーミング集計 (有界キュー、work stealing、ワーカーごとの部分和)
+    // =================================================================
+    const size_t stream_count = 64;
+    std::mt19937 stream_rng(20);
+    std::vector<StreamItem> stream_items(stream_count);
+    int expected_stream = 0;
+    for (StreamItem& item : stream_items) {
+        item.party = stream_rng() % 2;
+        item.bit = stream_rng() % 2;
+        expected_stream ^= item.bit;
+    }
+    StreamConfig stream_config;
+    stream_config.workers = 4;
+    stream_config.batch_size = 8;
+    stream_config.queue_capacity = 2;
+    StreamPipeline pipeline({h_zero, h_one}, params, stream_config);
+    pipeline.Push(std::vector<StreamItem>(stream_items.begin(), stream_items.begin() + stream_count / 2));
+    pipeline.Push(std::vector<StreamItem>(stream_items.begin() + stream_count / 2, stream_items.end()));
+    int dec_stream = pipeline.FinishAndDecrypt(PrecomputeDecryptionKey(f_combined));
+    pipeline.PrintStats(std::cout);
+    std::cout << "Stream (" << stream_count << " bits from 2 parties): " << dec_stream << " (Expected: "
+              << expected_stream << ") -> " << (dec_stream == expected_stream ? "SUCCESS" : "FAILURE") << std::endl;
+
+    return 0;
+}